@@ -27,8 +27,19 @@
 #define TELEINFO_UART_SPEED                 1200
 #define TELEINFO_UART_CONFIG                SERIAL_7E1
 #define TELEINFO_BUFFERSIZE                 512U
+#define TELEINFO_LOOP_MAXBYTES              64U     // Max bytes parsed per loop (TeleInfo sends 120 bytes/s)
+#ifndef TELEINFO_WORK
+#define TELEINFO_WORK(counter, n)                   // Parsing work accounting of the host tests (scanned, line bytes, label compares, moved bytes)
+#endif
 
 #define HISTORY_FLASH_START                 KNX_FLASH_SIZE
+#define HISTORY_EXPORT_VERSION              3
+#define HISTORY_EXPORT_OBJECT_INDEX         100     // Manufacturer object index (function property)
+#define HISTORY_EXPORT_PROPERTY_ID          201
+#ifndef HISTORY_EXPORT_CHUNK_SIZE
+#define HISTORY_EXPORT_CHUNK_SIZE           8       // Standard TP frame: 11 bytes of result data (3 bytes of header), raise only if extended frames are supported end to end
+#endif
+#define HISTORY_EXPORT_HOLD                 5000    // Clients starting a read within 5s get the same snapshot
 
 #define ADPS_REPEAT_PERIOD                  ( 10 * 1000 )   // Repeat ADPS > 0 every 10s 
 
@@ -37,11 +48,15 @@
 #define HISTORY_RESET_LED_BLINKING_PERIOD   512     // 0.512s
 #define RECEPTION_LED_BLINKING_PERIOD       512     // 0.512s
 
-#define FOURCC(a,b,c,d)                     ( ((((uint32_t)(a))<<24) | (((uint32_t)(b))<<16) | (((uint32_t)(c))<<8) | (d)) )
+#define WARMSTART_VERSION                   1
+#define WARMSTART_SNAPSHOT_PERIOD           1000    // 1s
+#define REPUBLISH_INTERVAL                  50      // 50ms between 2 republished group objects
+#define REPUBLISH_SPREAD                    5120    // Max delay before republishing, spread by device address (5.12s)
+
+// Core clock: MSI low power range (UARTs are clocked from HSI16, independent of the core clock)
+#define CLOCK_MSIRANGE                      RCC_MSIRANGE_6      // 4MHz
 
-// Restore ram after reset (brownout)
-#define INIT_MASK   0x12345678
-volatile uint32_t Inited __attribute__ ((section (".noinit")));
+#define FOURCC(a,b,c,d)                     ( ((((uint32_t)(a))<<24) | (((uint32_t)(b))<<16) | (((uint32_t)(c))<<8) | (d)) )
 
 class RTCKnx
 {
@@ -49,8 +64,9 @@ class RTCKnx
         if (isValid()) {
             uint32_t t = RTCKnx::millis();
             if (mLastSync != 0) {
-                const int64_t num = 1000 * (secondsSinceReference(mDateTimeStamp) - secondsSinceReference(mLastDateTime)) * mCorr.denum / mCorr.num;
-                const int64_t denum = ((num & ~(int64_t)UINT32_MAX)) + (t - mLastSync);
+                // Ratio of the elapsed bus time to the elapsed local time since the last synchronization
+                const int64_t num = 1000 * (secondsSinceReference(mDateTimeStamp) - secondsSinceReference(mLastDateTime));
+                const int64_t denum = t - mLastSync;
                 if (num != 0 && denum != 0 && num * 10 >= denum * 9 && num * 10 <= denum * 11) {
                     mCorr.num = num; mCorr.denum = denum;
                 }
@@ -66,9 +82,7 @@ class RTCKnx
   public:
     RTCKnx() {}
     void init(int baseAddr, uint16_t baseGO) {
-        if (mPersistentTimer != 0) new (&mDayCallback) std::function<void(DateChange)>();
         mLastSync = mLastRequested = 0;
-        mTimerOffset = mPersistentTimer; // Load last timer before reset
         mParams.period = knx.paramInt(baseAddr) * 60 * 1000;    // In minutes
         knx.getGroupObject(m_GO.date = ++baseGO).dataPointType(DPT_Date);
         knx.getGroupObject(m_GO.date).callback([this](GroupObject& go) {
@@ -190,12 +204,40 @@ class RTCKnx
     }
     enum DateChange { Init = -2, Same = -1, Day = 0, Month, Year };
     void setNotifier(const std::function<void(DateChange)>& notifier) { mDayCallback = notifier; }
-    uint32_t millis() { return mPersistentTimer = mTimerOffset + ::millis(); }
+    void requestSync() { mLastRequested = 0; }    // Ask Date/Time at next loop
+    uint32_t millis() { return mTimerOffset + ::millis(); }
     bool isValid() const { return mDateTimeStamp.tm_mday != 0 && mDateTimeStamp.tm_hour != 0xffff; } // Date + Time must be both set
+    struct Correction { int64_t num = 1, denum = 1; };
+    // Clock state kept in the warm start snapshot
+    struct Snapshot {
+        uint32_t timer;
+        uint32_t shift;
+        Correction corr;
+        DateTime dateTime;
+        DateTime lastEmittedDay;
+        DateTime lastDateTime;
+    };
+    void snapshot(Snapshot& snapshot) {
+        snapshot.timer = RTCKnx::millis();
+        snapshot.shift = mShift;
+        snapshot.corr = mCorr;
+        snapshot.dateTime = mDateTimeStamp;
+        snapshot.lastEmittedDay = mLastEmittedDay;
+        snapshot.lastDateTime = mLastDateTime;
+    }
+    void restore(const Snapshot& snapshot) {
+        mTimerOffset = snapshot.timer - ::millis();  // Timer continues from the snapshot
+        mShift = snapshot.shift;
+        mCorr = snapshot.corr;
+        mDateTimeStamp = snapshot.dateTime;
+        mLastEmittedDay = snapshot.lastEmittedDay;
+        mLastDateTime = snapshot.lastDateTime;
+        if (isValid())
+            updateStatus();
+    }
   private:
-    uint32_t mPersistentTimer = 0;   // Should stay after reset
     uint32_t mTimerOffset = 0;
-    struct { int64_t num = 1, denum = 1; } mCorr;
+    Correction mCorr;
     DateTime mDateTimeStamp = { 0, 0, 0xffff, 0, 0, 0 };
     DateTime mLastEmittedDay = {0};
     DateTime mLastDateTime = {0};
@@ -216,47 +258,132 @@ class RTCKnx
   public:
     enum { NBGO = sizeof(m_GO)/sizeof(uint16_t), SIZEPARAMS = sizeof(mParams) };
 };
-uint8_t rtcHolder[sizeof(RTCKnx)] __attribute__ ((section (".noinit")));
-RTCKnx& rtc = *(RTCKnx*)rtcHolder;
+RTCKnx rtc;
+
+// TIC field to KNX payload encoders: parse the raw field, write the DPT payload (big endian) and return its size
+// The parsed value is returned in 'value' (index, enum code or string signature)
+typedef uint8_t (*TeleInfoEncoder)(const char* begin, const char* end, uint32_t& value, uint8_t* payload);
+#define TELEINFO_PAYLOAD_MAXSIZE            14U     // DPT 16
+
+static inline uint32_t parseUInt(const char* begin, const char* end) {
+    uint32_t value = 0;
+    for (; begin != end; ++begin) {
+        const unsigned char v = (const unsigned char)(*begin - '0');
+        if (v > 9) break;
+        value = value * 10 + v;
+    }
+    return value;
+}
+static inline uint32_t parseFourCC(const char* begin, const char* end) {
+    uint32_t value = 0;
+    for (; begin != end; ++begin) {
+        value = (value<<8) | *(uint8_t*)begin;
+    }
+    return value;
+}
+static inline uint8_t writeUInt(uint8_t* payload, uint32_t value, uint8_t size) {
+    for (uint8_t i = size; i > 0; --i, value >>= 8) payload[i - 1] = (uint8_t)value;
+    return size;
+}
+static inline uint8_t writeFloat(uint8_t* payload, float value) {   // DPT 14
+    uint32_t raw; memcpy(&raw, &value, sizeof(raw));
+    return writeUInt(payload, raw, sizeof(raw));
+}
+template<uint8_t SIZE> static uint8_t encodeUInt(const char* begin, const char* end, uint32_t& value, uint8_t* payload) {  // DPT 5, 7, 13
+    value = parseUInt(begin, end);
+    return writeUInt(payload, SIZE < sizeof(uint32_t) ? MIN(value, (uint32_t)((1ULL << (8 * SIZE)) - 1)) : value, SIZE);   // Saturated
+}
+static uint8_t encodeFloat(const char* begin, const char* end, uint32_t& value, uint8_t* payload) {
+    return writeFloat(payload, (float)(value = parseUInt(begin, end)));
+}
+static uint8_t encodeString(const char* begin, const char* end, uint32_t& value, uint8_t* payload) {    // DPT 16
+    value = 0;
+    for (uint8_t i = 0; i < TELEINFO_PAYLOAD_MAXSIZE; ++i) {
+        payload[i] = begin != end ? *begin++ : 0;
+        value += value + payload[i];
+    }
+    return TELEINFO_PAYLOAD_MAXSIZE;
+}
+static uint8_t encodeChar(const char* begin, const char* end, uint32_t& value, uint8_t* payload) {  // DPT 4
+    return writeUInt(payload, value = parseFourCC(begin, end), 1);
+}
+static uint8_t encodeOptarif(const char* begin, const char* end, uint32_t& value, uint8_t* payload) {
+    value = parseFourCC(begin, end);
+    switch (value&0xffffff00) {
+        case FOURCC('B','A','S',0) /*BASE*/: default: value = 0; break;
+        case FOURCC('H','C','.',0) /*HC..*/: value = 1; break;
+        case FOURCC('E','J','P',0) /*EJP.*/: value = 2; break;
+        case FOURCC('B','B','R',0) /*BBRx*/: value &= 0x3f; break;
+//                                  - Bit 5: toujours 1
+//                                  - Bit 4-3: programme circuit 1: 01-11 _ programme A-C
+//                                  - Bit 2-0: programme circuit 2: 000-111 _ programme P0-P7
+    }
+    return writeUInt(payload, value, 1);
+}
+static uint8_t encodePtec(const char* begin, const char* end, uint32_t& value, uint8_t* payload) {
+    switch (parseFourCC(begin, end)) {
+        case FOURCC('T','H','.','.') /*Toutes les Heures*/: default: value = 0; break;
+        case FOURCC('H','C','.','.') /*Heures Creuses*/: value = 1; break;
+        case FOURCC('H','P','.','.') /*Heures Pleines*/: value = 2; break;
+        case FOURCC('H','N','.','.') /*Heures Normales*/: value = 3; break;
+        case FOURCC('P','M','.','.') /*Heures de Pointe Mobile*/: value = 4; break;
+        case FOURCC('H','C','J','B') /*Heures Creuses Jours Bleus*/: value = 5; break;
+        case FOURCC('H','C','J','W') /*Heures Creuses Jours Blancs*/: value = 6; break;
+        case FOURCC('H','C','J','R') /*Heures Creuses Jours Rouges*/: value = 7; break;
+        case FOURCC('H','P','J','B') /*Heures Pleines Jours Bleus*/: value = 8; break;
+        case FOURCC('H','P','J','W') /*Heures Pleines Jours Blancs*/: value = 9; break;
+        case FOURCC('H','P','J','R') /*Heures Pleines Jours Rouges*/: value = 10; break;
+    }
+    return writeUInt(payload, value, 1);
+}
+static uint8_t encodeDemain(const char* begin, const char* end, uint32_t& value, uint8_t* payload) {
+    switch (parseFourCC(begin, end)) {
+        case FOURCC('-','-','-','-'): default: value = 0; break;
+        case FOURCC('B','L','E','U'): value = 1; break;
+        case FOURCC('B','L','A','N'): value = 2; break;
+        case FOURCC('R','O','U','G'): value = 3; break;
+    }
+    return writeUInt(payload, value, 1);
+}
 
 struct TeleInfoDataType {
     const char* key;
-    uint8_t keySize : 4;
-    enum Type { INT = 0, STRING, OPTARIF, PTEC, DEMAIN, HHPHC } type : 4;
+    uint8_t keySize;
     uint8_t size;
     struct { short mainGroup; short subGroup; } dpt;
+    TeleInfoEncoder encode;
 };
 #define Dpt(M,S)    { M, S }
 static const TeleInfoDataType TeleInfoParam[] PROGMEM = {
-    { PSTR("ADCO "), 5, TeleInfoDataType::STRING, 12, DPT_String_ASCII },
-    { PSTR("OPTARIF "), 8, TeleInfoDataType::OPTARIF, 4, DPT_Value_1_Ucount },
-    { PSTR("ISOUSC "), 7, TeleInfoDataType::INT, 2, DPT_Value_Electric_Current },
-    { PSTR("BASE "), 5, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("HCHC "), 5, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("HCHP "), 5, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("EJPHN "), 6, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("EJPHPM "), 7, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("BBRHCJB "), 8, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("BBRHPJB "), 8, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("BBRHCJW "), 8, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("BBRHPJW "), 8, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("BBRHCJR "), 8, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("BBRHPJR "), 8, TeleInfoDataType::INT, 9, DPT_ActiveEnergy },
-    { PSTR("PEJP "), 5, TeleInfoDataType::INT, 2, DPT_TimePeriodMin },
-    { PSTR("PTEC "), 5, TeleInfoDataType::PTEC, 4, DPT_Value_1_Ucount },
-    { PSTR("DEMAIN "), 7, TeleInfoDataType::DEMAIN, 4, DPT_Value_1_Ucount },
-    { PSTR("IINST "), 6, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("ADPS "), 5, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("IMAX "), 5, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("PAPP "), 5, TeleInfoDataType::INT, 5, DPT_Value_2_Count }, // VA
-    { PSTR("HHPHC "), 6, TeleInfoDataType::HHPHC, 1, DPT_Char_ASCII },
-    { PSTR("IINST1 "), 7, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("IINST2 "), 7, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("IINST3 "), 7, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("IMAX1 "), 6, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("IMAX2 "), 6, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("IMAX3 "), 6, TeleInfoDataType::INT, 3, DPT_Value_Electric_Current },
-    { PSTR("PMAX "), 5, TeleInfoDataType::INT, 5, DPT_Value_Power }
+    { PSTR("ADCO "), 5, 12, DPT_String_ASCII, encodeString },
+    { PSTR("OPTARIF "), 8, 4, DPT_Value_1_Ucount, encodeOptarif },
+    { PSTR("ISOUSC "), 7, 2, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("BASE "), 5, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("HCHC "), 5, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("HCHP "), 5, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("EJPHN "), 6, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("EJPHPM "), 7, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("BBRHCJB "), 8, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("BBRHPJB "), 8, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("BBRHCJW "), 8, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("BBRHPJW "), 8, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("BBRHCJR "), 8, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("BBRHPJR "), 8, 9, DPT_ActiveEnergy, encodeUInt<4> },
+    { PSTR("PEJP "), 5, 2, DPT_TimePeriodMin, encodeUInt<2> },
+    { PSTR("PTEC "), 5, 4, DPT_Value_1_Ucount, encodePtec },
+    { PSTR("DEMAIN "), 7, 4, DPT_Value_1_Ucount, encodeDemain },
+    { PSTR("IINST "), 6, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("ADPS "), 5, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("IMAX "), 5, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("PAPP "), 5, 5, DPT_Value_2_Ucount, encodeUInt<2> }, // VA
+    { PSTR("HHPHC "), 6, 1, DPT_Char_ASCII, encodeChar },
+    { PSTR("IINST1 "), 7, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("IINST2 "), 7, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("IINST3 "), 7, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("IMAX1 "), 6, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("IMAX2 "), 6, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("IMAX3 "), 6, 3, DPT_Value_Electric_Current, encodeFloat },
+    { PSTR("PMAX "), 5, 5, DPT_Value_Power, encodeFloat }
 };
 #undef Dpt
 static const unsigned int TeleInfoCount = sizeof(TeleInfoParam)/sizeof(TeleInfoParam[0]);
@@ -266,12 +393,35 @@ class TeleInfo
     HardwareSerial mSerial = HardwareSerial(PIN_TELE_RX, PIN_TELE_TX);
     char mBuffer[TELEINFO_BUFFERSIZE];    // No '\0'
     int mBufferLen = 0;
+    int mScanLen = 0;   // Leading bytes of mBuffer already searched for end of line
 
     struct {
         uint32_t period;
         uint32_t realTimeTimeout;
+        uint32_t compound;
     } mParams;
     enum TarifBlock { Base = 0, HC, HP, /*BLUE, WHITE, RED,*/ TARIFCOUNT };
+    // Compound group objects (after TeleInfo group objects), layout in README
+    struct {
+        uint16_t currents;              // IINST1, IINST2, IINST3
+        uint16_t tariff[TARIFCOUNT];    // Today, This Month, This Year
+    } mCompoundGO;
+    // Tariff period accounting (indexes split at each PTEC/DEMAIN transition)
+    enum { FIRSTREGISTER = 3 /* BASE */, REGISTERCOUNT = 11 /* BASE to BBRHPJR */, REGISTERSLOTS = 6 };
+    struct {
+        uint16_t current;                   // Current tariff window
+        uint16_t previous;                  // Last closed tariff window
+        uint16_t today[REGISTERSLOTS];      // Today per index register of the OPTARIF
+    } mPeriodGO;
+    struct Periods {
+        uint32_t start[REGISTERCOUNT];      // Indexes at the beginning of the current tariff window
+        uint32_t today[REGISTERCOUNT];      // Today consumption of the closed windows (minus current window before day change)
+        uint32_t window;                    // Consumption of the current tariff window
+        uint32_t lastSent;
+        uint32_t lastSentValue;
+        uint32_t lastSentToday[REGISTERSLOTS];  // Last today sent per group object
+    } mPeriods = {0};
+    uint32_t mPeriodToday[REGISTERSLOTS] = {0};  // Today per group object (updatePeriodGroupObjects)
     struct {
         uint16_t realTimeOnOff;
         uint16_t realTimeOnOffState;
@@ -290,7 +440,11 @@ class TeleInfo
     uint32_t mHistoryLastSent = 0;
     uint32_t mLastReception = 0;
     uint32_t mLastManualHistoryInit = 0;
-    struct {
+    uint32_t mFlashWrites = 0;  // History flash saves since cold start
+    uint16_t mRepublish = 0;    // Next step of the republish sequence + 1 (0: idle)
+    uint32_t mRepublishNext = 0;
+    uint8_t mCompoundPending = 0;   // Compound group objects to send at the end of the frame (bit 0: currents, bit 1 + i: tariff i)
+    struct History {
         RTCKnx::DateTime lastSave;
         struct {
             uint32_t index;
@@ -302,92 +456,36 @@ class TeleInfo
             uint32_t yearM2;
         } tariff[TARIFCOUNT];
     } mHistory = {0};
+  public:
+    enum { EXPORT_SIZE = 2 + 7 + sizeof(mHistory.tariff) + 4 + 3 * 4 };
+  private:
+    static_assert(EXPORT_SIZE <= 0xff, "The export offset is 1 byte");
+    uint8_t mExport[EXPORT_SIZE];   // History snapshot being exported
+    uint8_t mExportSequence = 0;    // Incremented at each snapshot
+    uint32_t mExportTime = 0;       // Time of the snapshot (0: none)
 
     // Hold the memory buffer for all teleinfo
     struct TeleInfoDataStruct {
         uint16_t goSend;
         const TeleInfoDataType* conf; 
-        union {
-            char str[13];
-            uint32_t num;
-        } value;
-        uint32_t lastSendValueCheckSum;
+        uint32_t value;             // Index, enum code or string signature (set by the encoder)
+        uint32_t lastSendValue;
         uint32_t lastChange;
         uint32_t lastSend ;
     } mTeleInfoData[TeleInfoCount] = {0};
 
-    static inline KNXValue value(const TeleInfoDataStruct& val) {
-        switch (val.conf->type) {
-            default: case TeleInfoDataType::INT: return KNXValue(val.value.num);
-            case TeleInfoDataType::STRING: return KNXValue(val.value.str);
-            case TeleInfoDataType::OPTARIF:
-                switch (val.value.num&0xffffff00) {
-                    case FOURCC('B','A','S',0) /*BASE*/: default: return KNXValue((uint8_t)0);
-                    case FOURCC('H','C','.',0) /*HC..*/: return KNXValue((uint8_t)1);
-                    case FOURCC('E','J','P',0) /*EJP.*/: return KNXValue((uint8_t)2);
-                    case FOURCC('B','B','R',0) /*BBRx*/: return KNXValue((uint8_t)(val.value.num&0x3f));
-//                                  - Bit 5: toujours 1
-//                                  - Bit 4-3: programme circuit 1: 01-11 _ programme A-C
-//                                  - Bit 2-0: programme circuit 2: 000-111 _ programme P0-P7
-                }
-            case TeleInfoDataType::PTEC:
-                switch (val.value.num) {
-                    case FOURCC('T','H','.','.') /*Toutes les Heures*/: default: return KNXValue((uint8_t)0);
-                    case FOURCC('H','C','.','.') /*Heures Creuses*/: return KNXValue((uint8_t)1);
-                    case FOURCC('H','P','.','.') /*Heures Pleines*/: return KNXValue((uint8_t)2);
-                    case FOURCC('H','N','.','.') /*Heures Normales*/: return KNXValue((uint8_t)3);
-                    case FOURCC('P','M','.','.') /*Heures de Pointe Mobile*/: return KNXValue((uint8_t)4);
-                    case FOURCC('H','C','J','B') /*Heures Creuses Jours Bleus*/: return KNXValue((uint8_t)5);
-                    case FOURCC('H','C','J','W') /*Heures Creuses Jours Blancs*/: return KNXValue((uint8_t)6);
-                    case FOURCC('H','C','J','R') /*Heures Creuses Jours Rouges*/: return KNXValue((uint8_t)7);
-                    case FOURCC('H','P','J','B') /*Heures Pleines Jours Bleus*/: return KNXValue((uint8_t)8);
-                    case FOURCC('H','P','J','W') /*Heures Pleines Jours Blancs*/: return KNXValue((uint8_t)9);
-                    case FOURCC('H','P','J','R') /*Heures Pleines Jours Rouges*/: return KNXValue((uint8_t)10);
-                }
-            case TeleInfoDataType::DEMAIN:
-                switch (val.value.num) {
-                    case FOURCC('-','-','-','-'): default: return KNXValue((uint8_t)0);
-                    case FOURCC('B','L','E','U'): return KNXValue((uint8_t)1);
-                    case FOURCC('B','L','A','N'): return KNXValue((uint8_t)2);
-                    case FOURCC('R','O','U','G'): return KNXValue((uint8_t)3);
-                }
-            case TeleInfoDataType::HHPHC: return KNXValue((uint8_t)val.value.num);
-        }
-    }
-
+    // Encode the TIC field straight into the group object payload, return true if the payload changed (or is the first one received)
     static inline bool value(TeleInfoDataStruct& val, const char* begin, const char* end) {
         begin += val.conf->keySize;
         const char* vEnd = begin + val.conf->size;
         if (vEnd < end) {
-            if (val.conf->type == TeleInfoDataType::STRING) {
-                const uint8_t size = val.conf->size;
-                if (memcmp(val.value.str, begin, size) != 0) {
-                    memcpy(val.value.str, begin, size);
-                    val.value.str[size] = '\0';
-                    return true;
-                }
-            }
-            else if (val.conf->type == TeleInfoDataType::INT) {
-                uint32_t _value = 0;
-                for (; begin != vEnd; ++begin) {
-                    const unsigned char v = (const unsigned char)(*begin - '0');
-                    if (v > 9) break;
-                    _value = _value * 10 + v;
-                }
-                if (val.value.num != _value) {
-                    val.value.num = _value;
-                    return true;
-                }
-            }
-            else {
-                uint32_t _value = 0;
-                for (; begin != vEnd; ++begin) {
-                    _value = (_value<<8) | *(uint8_t*)begin;
-                }
-                if (val.value.num != _value) {
-                    val.value.num = _value;
-                    return true;
-                }
+            uint8_t payload[TELEINFO_PAYLOAD_MAXSIZE];
+            GroupObject& go = knx.getGroupObject(val.goSend);
+            const size_t size = val.conf->encode(begin, vEnd, val.value, payload);
+            if (size != go.valueSize()) return false;  // Group object size does not match the DPT (ETS database)
+            if (val.lastChange == 0 || memcmp(go.valueRef(), payload, size) != 0) {
+                memcpy(go.valueRef(), payload, size);
+                return true;
             }
         }
         return false;
@@ -398,31 +496,24 @@ class TeleInfo
         uint8_t spaceFound = 0;
         for (; begin != end; ++begin) {
             const char c = *begin;
+            if (spaceFound == 2) {
+                // checksum after second space (can be a space itself)
+                return (((uint8_t)(sum - ' ') & 0x3F) + 0x20) == c;
+            }
             if (c == ' ') {
                 ++spaceFound;
             }
-            else if (spaceFound == 2) {
-                // checksum after second space
-                return (((uint8_t)(sum - ' ') & 0x3F) + 0x20) == c;
-            }
             sum += c;
         }
         return false;
     }
 
-    static inline uint32_t simpleChecksum(const char* str) {
-        uint32_t result = 0;
-        while (*str) result += result + *str++;
-        return result;
-    }
 public:
     TeleInfo() {}
     void init(int baseAddr, uint16_t baseGO) {
         mParams.period = knx.paramInt(baseAddr) * 1000; // In Seconds
         mParams.realTimeTimeout = knx.paramInt(baseAddr + 4) * 60 * 1000;   // In Minutes
-        if (mLastReception == 0) {  // Cold reset
-            restoreHistory();
-        }
+        restoreHistory();   // Overridden by the warm start snapshot if valid
         knx.getGroupObject(mGO.realTimeOnOff = ++baseGO).dataPointType(DPT_Switch);
         knx.getGroupObject(mGO.realTimeOnOff).callback([this](GroupObject& go) { mRealTimeTimer = go.value() ? rtc.millis()|1 : 0; });
         knx.getGroupObject(mGO.realTimeOnOffState = ++baseGO).dataPointType(DPT_Switch);
@@ -456,9 +547,25 @@ public:
         resyncHistoryGroupObjects();
         const TeleInfoDataType* param = TeleInfoParam;
         for (TeleInfoDataStruct * data = mTeleInfoData; data != mTeleInfoData + TeleInfoCount; ++data, ++param) {
-            data->conf = param; data->value.num = 0;
-            knx.getGroupObject(data->goSend = ++baseGO).dataPointType(Dpt(data->conf->dpt.mainGroup, data->conf->dpt.subGroup));
-            knx.getGroupObject(data->goSend).valueNoSend(value(*data));
+            data->conf = param; data->value = 0;
+            GroupObject& go = knx.getGroupObject(data->goSend = ++baseGO);
+            go.dataPointType(Dpt(data->conf->dpt.mainGroup, data->conf->dpt.subGroup));
+            memset(go.valueRef(), 0, go.valueSize());
+        }
+        // Product database before application version 17: no compound nor tariff period group objects, no compound parameter
+        const uint16_t goCount = knx.bau().groupObjectTable().entryCount();
+        mCompoundGO.currents = ++baseGO;
+        for (int i = 0; i < TARIFCOUNT; ++i) {
+            mCompoundGO.tariff[i] = ++baseGO;
+        }
+        mParams.compound = goCount >= baseGO ? knx.paramInt(baseAddr + 8) : 0;
+        mPeriodGO = {};
+        if (goCount >= baseGO + 2 + REGISTERSLOTS) {
+            knx.getGroupObject(mPeriodGO.current = ++baseGO).dataPointType(DPT_ActiveEnergy);
+            knx.getGroupObject(mPeriodGO.previous = ++baseGO).dataPointType(DPT_ActiveEnergy);
+            for (int i = 0; i < REGISTERSLOTS; ++i) {
+                knx.getGroupObject(mPeriodGO.today[i] = ++baseGO).dataPointType(DPT_ActiveEnergy);
+            }
         }
         mBufferLen = 0;
         mSerial.begin(TELEINFO_UART_SPEED, TELEINFO_UART_CONFIG);
@@ -490,6 +597,170 @@ public:
 
     uint32_t lastReception() const { return mLastReception; }
 
+    // Serve a chunk of the history export (layout in README) and the sequence number of its snapshot
+    // A request at offset 0 takes a new snapshot, unless the current one is recent: clients reading concurrently share it
+    uint8_t exportHistory(uint8_t offset, uint8_t* data, uint8_t maxLength, uint8_t& sequence) {
+        const uint32_t current = rtc.millis()|1;
+        if (offset == 0 && (mExportTime == 0 || current - mExportTime > HISTORY_EXPORT_HOLD)) {
+            uint8_t* ptr = mExport;
+            *ptr++ = HISTORY_EXPORT_VERSION;
+            *ptr++ = TARIFCOUNT;
+            ptr += writeUInt(ptr, mHistory.lastSave.tm_year, 2);
+            *ptr++ = mHistory.lastSave.tm_mon + 1; *ptr++ = mHistory.lastSave.tm_mday;
+            *ptr++ = mHistory.lastSave.tm_hour; *ptr++ = mHistory.lastSave.tm_min; *ptr++ = mHistory.lastSave.tm_sec;
+            for (int i = 0; i < TARIFCOUNT; ++i) {
+                const uint32_t* indexes = (const uint32_t*)&mHistory.tariff[i];
+                for (size_t j = 0; j < sizeof(mHistory.tariff[i])/sizeof(uint32_t); ++j) {
+                    ptr += writeUInt(ptr, indexes[j], sizeof(uint32_t));
+                }
+            }
+            ptr += writeUInt(ptr, mFlashWrites, sizeof(uint32_t));
+            // Core clock statistics (version 3): the core stays in the low power range, no switch
+            ptr += writeUInt(ptr, 0, sizeof(uint32_t));
+            ptr += writeUInt(ptr, 0, sizeof(uint32_t));
+            writeUInt(ptr, ::millis(), sizeof(uint32_t));
+            ++mExportSequence;
+            mExportTime = current;
+        }
+        sequence = mExportSequence;
+        if (mExportTime == 0 || offset >= sizeof(mExport)) return 0;
+        const uint8_t length = MIN((size_t)maxLength, sizeof(mExport) - offset);
+        memcpy(data, mExport + offset, length);
+        return length;
+    }
+
+    // TeleInfo state kept in the warm start snapshot
+    struct Snapshot {
+        History history;
+        uint32_t historyLastValue[TARIFCOUNT];
+        uint32_t historyLastSent;
+        uint32_t realTimeTimer;
+        uint32_t lastReception;
+        uint32_t flashWrites;
+        Periods periods;
+        struct {
+            uint32_t value;
+            uint32_t lastSendValue;
+            uint32_t lastChange;
+            uint32_t lastSend;
+            uint8_t payload[TELEINFO_PAYLOAD_MAXSIZE];
+        } data[TeleInfoCount];
+    };
+    void snapshot(Snapshot& snapshot) const {
+        snapshot.history = mHistory;
+        memcpy(snapshot.historyLastValue, mHistoryLastValue, sizeof(mHistoryLastValue));
+        snapshot.historyLastSent = mHistoryLastSent;
+        snapshot.realTimeTimer = mRealTimeTimer;
+        snapshot.lastReception = mLastReception;
+        snapshot.flashWrites = mFlashWrites;
+        snapshot.periods = mPeriods;
+        for (unsigned int i = 0; i < TeleInfoCount; ++i) {
+            const TeleInfoDataStruct& data = mTeleInfoData[i];
+            GroupObject& go = knx.getGroupObject(data.goSend);
+            snapshot.data[i].value = data.value; snapshot.data[i].lastSendValue = data.lastSendValue;
+            snapshot.data[i].lastChange = data.lastChange; snapshot.data[i].lastSend = data.lastSend;
+            memcpy(snapshot.data[i].payload, go.valueRef(), MIN(go.valueSize(), sizeof(snapshot.data[i].payload)));
+        }
+    }
+    void restore(const Snapshot& snapshot) {
+        mHistory = snapshot.history;
+        memcpy(mHistoryLastValue, snapshot.historyLastValue, sizeof(mHistoryLastValue));
+        mHistoryLastSent = snapshot.historyLastSent;
+        mRealTimeTimer = snapshot.realTimeTimer;
+        mLastReception = snapshot.lastReception;
+        mFlashWrites = snapshot.flashWrites;
+        mPeriods = snapshot.periods;
+        for (unsigned int i = 0; i < TeleInfoCount; ++i) {
+            TeleInfoDataStruct& data = mTeleInfoData[i];
+            GroupObject& go = knx.getGroupObject(data.goSend);
+            data.value = snapshot.data[i].value; data.lastSendValue = snapshot.data[i].lastSendValue;
+            data.lastChange = snapshot.data[i].lastChange; data.lastSend = snapshot.data[i].lastSend;
+            memcpy(go.valueRef(), snapshot.data[i].payload, MIN(go.valueSize(), sizeof(snapshot.data[i].payload)));
+        }
+        knx.getGroupObject(mGO.realTimeOnOffState).valueNoSend(mRealTimeTimer != 0);
+        resyncHistoryGroupObjects();
+        mPeriods.window = updatePeriodGroupObjects();
+        republish();
+    }
+
+    // Emit again all transmitting group objects holding a known value, paced by REPUBLISH_INTERVAL
+    // The start is delayed according to the device number, so that devices of the line restarting together do not collide
+    void republish() {
+        mRepublish = 1;
+        mRepublishNext = rtc.millis() + (knx.individualAddress() & 0xff) * (REPUBLISH_SPREAD / 256);
+    }
+    // Emit the group object of the current republish step, return false if nothing was emitted at this step
+    bool republishStep() {
+        const unsigned int step = mRepublish++ - 1;
+        const unsigned int periodCount = sizeof(mGO.tariff[0])/sizeof(uint16_t), historyCount = TARIFCOUNT * periodCount;
+        uint16_t go = 0;
+        if (step == 0) {
+            go = mGO.realTimeOnOffState;
+        }
+        else if (step - 1 < historyCount) {
+            const int i = (step - 1) / periodCount, period = (step - 1) % periodCount;
+            // Reference index of each history group object (today, yesterday, thisMonth, lastMonth, thisYear, lastYear)
+            const uint32_t refs[] = { mHistory.tariff[i].yesterday, mHistory.tariff[i].dayM2, mHistory.tariff[i].lastMonth, mHistory.tariff[i].monthM2, mHistory.tariff[i].lastYear, mHistory.tariff[i].yearM2 };
+            if (rtc.isValid() && refs[period] != 0)
+                go = (&mGO.tariff[i].today)[period];
+        }
+        else if (step - 1 - historyCount < TeleInfoCount) {
+            TeleInfoDataStruct& data = mTeleInfoData[step - 1 - historyCount];
+            if (data.lastChange != 0) {
+                go = data.goSend;
+                data.lastSendValue = data.value;
+                data.lastSend = rtc.millis()|1;
+            }
+        }
+        else if (step - 1 - historyCount - TeleInfoCount < 1 + TARIFCOUNT) {
+            const unsigned int compound = step - 1 - historyCount - TeleInfoCount;
+            if (!mParams.compound) return false;
+            if (compound == 0) {
+                if (mTeleInfoData[22 /* IINST1 */].lastChange == 0) return false;
+                sendCompoundCurrents();
+            }
+            else {
+                if (!rtc.isValid()) return false;
+                sendCompoundTariff(compound - 1);
+            }
+            return true;
+        }
+        else if (step - 1 - historyCount - TeleInfoCount - 1 - TARIFCOUNT < REGISTERSLOTS + 1) {
+            const unsigned int period = step - 1 - historyCount - TeleInfoCount - 1 - TARIFCOUNT;
+            int first, count;
+            activeRegisters(first, count);
+            if (mPeriodGO.current == 0 || mPeriods.start[first] == 0 || (period != 0 && period - 1 >= (unsigned int)count)) return false;
+            go = period == 0 ? mPeriodGO.current : mPeriodGO.today[period - 1];
+        }
+        else {
+            mRepublish = 0;
+            return true;
+        }
+        if (go == 0) return false;
+        knx.getGroupObject(go).objectWritten();
+        return true;
+    }
+
+    // Three phase currents: 3 x 2 bytes (A)
+    void sendCompoundCurrents() {
+        GroupObject& go = knx.getGroupObject(mCompoundGO.currents);
+        if (go.valueSize() < 3 * 2) return;
+        uint8_t* payload = go.valueRef();
+        for (int i = 0; i < 3; ++i) {
+            payload += writeUInt(payload, mTeleInfoData[22 /* IINST1 */ + i].value, 2);
+        }
+        go.objectWritten();
+    }
+    // Tariff consumption: 3 x 4 bytes (Wh) copied from the DPT 13 history group objects
+    void sendCompoundTariff(int idxTariff) {
+        GroupObject& go = knx.getGroupObject(mCompoundGO.tariff[idxTariff]);
+        if (go.valueSize() < 3 * 4) return;
+        memcpy(go.valueRef(), knx.getGroupObject(mGO.tariff[idxTariff].today).valueRef(), 4);
+        memcpy(go.valueRef() + 4, knx.getGroupObject(mGO.tariff[idxTariff].thisMonth).valueRef(), 4);
+        memcpy(go.valueRef() + 8, knx.getGroupObject(mGO.tariff[idxTariff].thisYear).valueRef(), 4);
+        go.objectWritten();
+    }
+
     void loop() {
         uint32_t current = rtc.millis()|1;
         bool isRealTime = knx.getGroupObject(mGO.realTimeOnOffState).value();
@@ -510,14 +781,17 @@ public:
             saveHistory();
             mLastManualHistoryInit = 0;
         }
-        for (;;) {
-            unsigned int pending = mSerial.available();
+        // Bounded parsing per call: a noisy TeleInfo line cannot starve the KNX stack
+        bool frameEnd = false, periodChange = false, indexChange = false;  // Reported by the parsing of this loop
+        for (unsigned int budget = TELEINFO_LOOP_MAXBYTES; budget > 0;) {
+            unsigned int pending = MIN((unsigned int)mSerial.available(), budget);
             if (pending == 0)
                 break;
+            budget -= pending;
 
             while (pending > 0) {
                 if (mBufferLen == TELEINFO_BUFFERSIZE) {
-                    mBufferLen = 0;  // Security - Reset buffer if full with dummies
+                    mBufferLen = mScanLen = 0;  // Security - Reset buffer if full with dummies
                     break;
                 }
                 unsigned int rcv = 0, ready = MIN(TELEINFO_BUFFERSIZE - mBufferLen, pending);
@@ -527,6 +801,7 @@ public:
                     if (c < 0) {
                         break;
                     }
+                    frameEnd |= c == '\x03';  // ETX
                     *ptr++ = (char)c;
                     ++rcv;
                 }
@@ -535,16 +810,18 @@ public:
                 pending -= rcv;
                 mBufferLen += rcv;
                 const char* currentBuffer = mBuffer;
+                const char* eol = mBuffer + mScanLen;   // Bytes before were already scanned without CR
                 for (;;) {
                     // extract first line if 
-                    const char* eol = currentBuffer;
                     for (; eol != mBuffer + mBufferLen; ++eol) {
+                        TELEINFO_WORK(scanned, 1);
                         if (*eol == '\x0d') {
                             break;
                         }
                     }
                     if(eol == mBuffer + mBufferLen)
                         break;
+                    TELEINFO_WORK(lines, eol - currentBuffer);
                     // search first valid character
                     for (; currentBuffer != eol; ++currentBuffer) {
                         const char c = *currentBuffer;
@@ -556,19 +833,25 @@ public:
                     if (TeleInfo::validChecksum(currentBuffer, eol)) {
                         mLastReception = current;
                         for (TeleInfoDataStruct * data = mTeleInfoData; data != mTeleInfoData + TeleInfoCount; ++data) {
+                            TELEINFO_WORK(compares, 1);
                             if (lineLen > data->conf->keySize && memcmp(currentBuffer, data->conf->key, data->conf->keySize) == 0) {
                                 if (TeleInfo::value(*data, currentBuffer, eol)) {
                                     data->lastChange = current;
-                                    knx.getGroupObject(data->goSend).valueNoSend(TeleInfo::value(*data));
+                                    periodChange |= data == &mTeleInfoData[15 /* PTEC */] || data == &mTeleInfoData[16 /* DEMAIN */];
+                                    indexChange |= data >= &mTeleInfoData[FIRSTREGISTER] && data < &mTeleInfoData[FIRSTREGISTER + REGISTERCOUNT];
                                 }
                                 break;
                             }
                         }
                     }
-                    currentBuffer = eol + 1;
+                    eol = currentBuffer = eol + 1;
                 }
-                mBufferLen -= currentBuffer - mBuffer;
-                memmove(mBuffer, currentBuffer, mBufferLen);
+                if (currentBuffer != mBuffer) {
+                    mBufferLen -= currentBuffer - mBuffer;
+                    TELEINFO_WORK(moved, mBufferLen);
+                    memmove(mBuffer, currentBuffer, mBufferLen);
+                }
+                mScanLen = mBufferLen;
             }
         }
 
@@ -579,20 +862,20 @@ public:
             const TeleInfoDataStruct* iinsts[] = { &mTeleInfoData[17 /* IINST*/], &mTeleInfoData[22 /* IINST1*/], &mTeleInfoData[23 /* IINST2*/], &mTeleInfoData[24 /* IINST3*/] };
             const TeleInfoDataStruct* maxiinst = nullptr;
             for (size_t i = 0; i < sizeof(iinsts)/sizeof(iinsts[0]); ++i) {
-                if (!maxiinst || maxiinst->value.num < iinsts[i]->value.num) {
+                if (!maxiinst || maxiinst->value < iinsts[i]->value) {
                     maxiinst = iinsts[i];
                 }
             }
             if (maxiinst && maxiinst->lastChange != 0 && (current == maxiinst->lastChange || current == isousc.lastChange)) {
-                uint32_t adpsValue = maxiinst->value.num > isousc.value.num?maxiinst->value.num - isousc.value.num:0;
-                if (adps.value.num != adpsValue) {
-                    adps.value.num = adpsValue;
+                uint32_t adpsValue = maxiinst->value > isousc.value?maxiinst->value - isousc.value:0;
+                if (adps.value != adpsValue) {
+                    adps.value = adpsValue;
                     adps.lastChange = current;
-                    knx.getGroupObject(adps.goSend).valueNoSend(adpsValue);
+                    writeFloat(knx.getGroupObject(adps.goSend).valueRef(), (float)adpsValue);
                 }
             }
-            if (current == adps.lastChange || (adps.value.num > 0 && current - adps.lastSend > ADPS_REPEAT_PERIOD)) {
-                adps.lastSendValueCheckSum = adps.value.num;
+            if (current == adps.lastChange || (adps.value > 0 && current - adps.lastSend > ADPS_REPEAT_PERIOD)) {
+                adps.lastSendValue = adps.value;
                 knx.getGroupObject(adps.goSend).objectWritten(); // Emit is forced
                 adps.lastSend = current;
             }
@@ -601,17 +884,18 @@ public:
         // Send if value has changed and period is over
         for (TeleInfoDataStruct * data = mTeleInfoData; data != mTeleInfoData + TeleInfoCount; ++data) {
             if (data->lastChange != data->lastSend && (isRealTime || current - data->lastSend > mParams.period)) {
-                uint32_t chksum = data->conf->type == TeleInfoDataType::STRING?simpleChecksum(data->value.str):data->value.num;
-                if (chksum != data->lastSendValueCheckSum) {
-                    data->lastSendValueCheckSum = chksum;
+                if (data->value != data->lastSendValue || data->lastSend == 0 /* First value */) {
+                    data->lastSendValue = data->value;
                     knx.getGroupObject(data->goSend).objectWritten();
                     data->lastSend = current;
+                    if (mParams.compound && data >= &mTeleInfoData[22 /* IINST1 */] && data <= &mTeleInfoData[24 /* IINST3 */])
+                        mCompoundPending |= 1;
                 }
             }
         }
 
-        // Update history
-        if (mTeleInfoData[1 /* OPTARIF */].lastChange != 0) {
+        // Update history (a frame is parsed across several loops: wait for all the indexes of the OPTARIF)
+        if (mTeleInfoData[1 /* OPTARIF */].lastChange != 0 && indexesReceived()) {
             uint32_t index[TARIFCOUNT] = {0};
             currentIndexes(index);
             for (int i = 0; i < TARIFCOUNT; ++i) {
@@ -636,34 +920,147 @@ public:
                         knx.getGroupObject(mGO.tariff[i].today).objectWritten();
                         knx.getGroupObject(mGO.tariff[i].thisMonth).objectWritten();
                         knx.getGroupObject(mGO.tariff[i].thisYear).objectWritten();
+                        if (mParams.compound)
+                            mCompoundPending |= 2 << i;
                         mHistoryLastSent = current;
                         mHistoryLastValue[i] = index[i];
                     }
                 }
             }
         }
+
+        // Compound group objects: once per frame (lines are parsed in different loops), with the values sent during the frame
+        if (frameEnd && mCompoundPending != 0) {
+            if (mCompoundPending & 1)
+                sendCompoundCurrents();
+            for (int i = 0; i < TARIFCOUNT; ++i) {
+                if (mCompoundPending & (2 << i))
+                    sendCompoundTariff(i);
+            }
+            mCompoundPending = 0;
+        }
+
+        // Tariff period accounting: exact split at PTEC/DEMAIN transitions (indexes come before them in a frame), if the product database has its group objects
+        if (mPeriodGO.current != 0) {
+            bool indexChanged = indexChange;
+            if (periodChange) {
+                splitPeriod();
+                indexChanged = true;
+            }
+            int first, count;
+            activeRegisters(first, count);
+            // Cold start: the first window starts at the first complete set of indexes, the PTEC/DEMAIN of a partial frame may come first
+            if (mTeleInfoData[1 /* OPTARIF */].lastChange != 0 && indexesReceived()) {
+                for (int i = 0; i < count; ++i) {
+                    if (mPeriods.start[first + i] == 0 && mTeleInfoData[FIRSTREGISTER + first + i].value != 0) {
+                        mPeriods.start[first + i] = mTeleInfoData[FIRSTREGISTER + first + i].value;
+                        mPeriods.lastSentValue = mPeriods.lastSentToday[i] = UINT32_MAX;   // Emit the new window
+                        indexChanged = true;
+                    }
+                }
+            }
+            if (indexChanged) {
+                mPeriods.window = updatePeriodGroupObjects();
+            }
+            // Only the group objects whose value changed: a window change leaves the today values as they are
+            if (mPeriods.start[first] != 0 && (isRealTime || current - mPeriods.lastSent > mParams.period)) {
+                if (mPeriods.window != mPeriods.lastSentValue) {
+                    knx.getGroupObject(mPeriodGO.current).objectWritten();
+                    mPeriods.lastSentValue = mPeriods.window;
+                    mPeriods.lastSent = current;
+                }
+                for (int i = 0; i < count; ++i) {
+                    if (mPeriodToday[i] != mPeriods.lastSentToday[i]) {
+                        knx.getGroupObject(mPeriodGO.today[i]).objectWritten();
+                        mPeriods.lastSentToday[i] = mPeriodToday[i];
+                        mPeriods.lastSent = current;
+                    }
+                }
+            }
+        }
+
+        // Republish sequence (warm start, bus recovery)
+        if (mRepublish != 0 && (int32_t)(current - mRepublishNext) >= 0) {
+            while (mRepublish != 0 && !republishStep()) {}
+            mRepublishNext = current + REPUBLISH_INTERVAL;
+        }
+    }
+    // Index registers (from FIRSTREGISTER) counting for the current OPTARIF
+    void activeRegisters(int& first, int& count) const {
+        switch (mTeleInfoData[1 /* OPTARIF */].value) {
+            case 0 /* Base */: first = 3 /* BASE */ - FIRSTREGISTER; count = 1; break;
+            case 1 /* HCHP */: first = 4 /* HCHC */ - FIRSTREGISTER; count = 2; break;
+            case 2 /* EJP */: first = 6 /* EJPHN */ - FIRSTREGISTER; count = 2; break;
+            default /* Tempo */: first = 8 /* BBRHCJB */ - FIRSTREGISTER; count = 6; break;
+        }
+    }
+    // All the index registers of the current OPTARIF were received
+    bool indexesReceived() const {
+        int first, count;
+        activeRegisters(first, count);
+        for (int i = 0; i < count; ++i) {
+            if (mTeleInfoData[FIRSTREGISTER + first + i].lastChange == 0) return false;
+        }
+        return true;
+    }
+    // Close the current tariff window on all index registers
+    void splitPeriod() {
+        bool started = false;
+        uint32_t window = 0;
+        for (int r = 0; r < REGISTERCOUNT; ++r) {
+            const uint32_t index = mTeleInfoData[FIRSTREGISTER + r].value;
+            if (mPeriods.start[r] != 0 && index >= mPeriods.start[r]) {
+                mPeriods.today[r] += index - mPeriods.start[r];
+                window += index - mPeriods.start[r];
+                started = true;
+            }
+            mPeriods.start[r] = index;
+        }
+        if (started && mPeriodGO.previous != 0) {
+            knx.getGroupObject(mPeriodGO.previous).value(window);
+        }
+        mPeriods.lastSentValue = UINT32_MAX;   // Emit the new window
+    }
+    // Return the consumption of the current tariff window
+    uint32_t updatePeriodGroupObjects() {
+        int first, count;
+        activeRegisters(first, count);
+        uint32_t window = 0;
+        for (int i = 0; i < REGISTERSLOTS; ++i) {
+            uint32_t today = 0;
+            if (i < count && mPeriods.start[first + i] != 0) {
+                const uint32_t index = mTeleInfoData[FIRSTREGISTER + first + i].value;
+                today = mPeriods.today[first + i] + (index - mPeriods.start[first + i]);
+                window += index - mPeriods.start[first + i];
+            }
+            mPeriodToday[i] = today;
+            if (mPeriodGO.today[i] != 0)
+                knx.getGroupObject(mPeriodGO.today[i]).valueNoSend(today);
+        }
+        if (mPeriodGO.current != 0)
+            knx.getGroupObject(mPeriodGO.current).valueNoSend(window);
+        return window;
     }
     void currentIndexes(uint32_t index[TARIFCOUNT]) const {
         // depending on OPTARIF
-        uint8_t optarif = value(mTeleInfoData[1 /* OPTARIF */]);
-        switch (optarif) {
-            case 0: case 1 /* Base */:
-                index[Base] = mTeleInfoData[3 /* BASE */].value.num;
+        switch (mTeleInfoData[1 /* OPTARIF */].value) {
+            case 0 /* Base */:
+                index[Base] = mTeleInfoData[3 /* BASE */].value;
             break;
-            case 2 /* HCHP */:
-                index[HC] = mTeleInfoData[4 /* HCHC */].value.num;
-                index[HP] = mTeleInfoData[5 /* HCHP */].value.num;
+            case 1 /* HCHP */:
+                index[HC] = mTeleInfoData[4 /* HCHC */].value;
+                index[HP] = mTeleInfoData[5 /* HCHP */].value;
                 index[Base] = index[HC] + index[HP];
             break;
-            case 3 /* EJP */:
-                index[HC] = mTeleInfoData[6 /* EJPHN */].value.num;
-                index[HP] = mTeleInfoData[7 /* EJPHPM */].value.num;
+            case 2 /* EJP */:
+                index[HC] = mTeleInfoData[6 /* EJPHN */].value;
+                index[HP] = mTeleInfoData[7 /* EJPHPM */].value;
                 index[Base] = index[HC] + index[HP];
             break;
             default/* Tempo */: {
-                uint32_t blueHC = mTeleInfoData[8 /* BBRHCJB */].value.num, blueHP = mTeleInfoData[9 /* BBRHPJB */].value.num,
-                         whiteHC = mTeleInfoData[10 /* BBRHCJW */].value.num, whiteHP = mTeleInfoData[11 /* BBRHPJW */].value.num,
-                         redHC = mTeleInfoData[12 /* BBRHCJR */].value.num, redHP = mTeleInfoData[13 /* BBRHPJR */].value.num;
+                uint32_t blueHC = mTeleInfoData[8 /* BBRHCJB */].value, blueHP = mTeleInfoData[9 /* BBRHPJB */].value,
+                         whiteHC = mTeleInfoData[10 /* BBRHCJW */].value, whiteHP = mTeleInfoData[11 /* BBRHPJW */].value,
+                         redHC = mTeleInfoData[12 /* BBRHCJR */].value, redHP = mTeleInfoData[13 /* BBRHPJR */].value;
                 index[HC] = blueHC + whiteHC + redHC;
                 index[HP] = blueHP + whiteHP + redHP;
                 //index[BLUE] = blueHC + blueHP; index[WHITE] = whiteHC + whiteHP; index[RED] = redHC + redHP;
@@ -676,6 +1073,7 @@ public:
             validateHistory();
             return;
         }
+        bool save = false;
         switch (change) {
             case RTCKnx::Year:
                 for (int i = 0; i < TARIFCOUNT; ++i) {
@@ -692,7 +1090,7 @@ public:
                     if (mHistory.tariff[i].monthM2 != 0)
                         knx.getGroupObject(mGO.tariff[i].lastMonth).value(mHistory.tariff[i].lastMonth - mHistory.tariff[i].monthM2);
                 }
-                saveHistory(); // Save only each month (due to flash write cycle limited to 10000)
+                save = true; // Save only each month (due to flash write cycle limited to 10000)
             [[fallthrough]];
             case RTCKnx::Day:
                 for (int i = 0; i < TARIFCOUNT; ++i) {
@@ -701,9 +1099,18 @@ public:
                     if (mHistory.tariff[i].dayM2 != 0)
                         knx.getGroupObject(mGO.tariff[i].yesterday).value(mHistory.tariff[i].yesterday - mHistory.tariff[i].dayM2);
                 }
+                // Today per register restarts from the current index, the current tariff window goes on:
+                // today is today[r] + (index - start[r]) (modulo 2^32), it is 0 at the day change with today[r] = start[r] - index
+                for (int r = 0; r < REGISTERCOUNT; ++r) {
+                    mPeriods.today[r] = mPeriods.start[r] != 0 ? mPeriods.start[r] - mTeleInfoData[FIRSTREGISTER + r].value : 0;
+                }
+                mPeriods.window = updatePeriodGroupObjects();   // Today group objects sent by the next loop
             [[fallthrough]];
             default:;
         }
+        if (save) {
+            saveHistory();  // Once yesterday is rotated as well: the history restored on the save day is up to date
+        }
     }
     void validateHistory() {
         if (mHistory.lastSave.tm_mday == 0) return; 
@@ -737,14 +1144,24 @@ public:
         const RTCKnx::DateTime& dateTime = rtc.dateTime();
         mHistory.lastSave = dateTime;
         uint8_t checksum = 0;
+        bool changed = false;
         for (size_t i = 0; i < sizeof(mHistory); ++i) {
-            eeprom_buffered_write_byte(HISTORY_FLASH_START + i, *((uint8_t*)&mHistory + i));
-            checksum ^= *((uint8_t*)&mHistory + i);
+            const uint8_t v = *((uint8_t*)&mHistory + i);
+            if (eeprom_buffered_read_byte(HISTORY_FLASH_START + i) != v) {
+                eeprom_buffered_write_byte(HISTORY_FLASH_START + i, v);
+                changed = true;
+            }
+            checksum ^= v;
         }
         if (checksum != eeprom_buffered_read_byte(HISTORY_FLASH_START + sizeof(mHistory))) {
             eeprom_buffered_write_byte(HISTORY_FLASH_START + sizeof(mHistory), checksum);
+            changed = true;
+        }
+        // Flush whenever the content changed (an unchanged 8-bit checksum does not mean unchanged data)
+        if (changed) {
+            ++mFlashWrites;
             eeprom_buffer_flush();
-        } 
+        }
     }
     void resetHistory() {
         mHistory = {0};
@@ -762,26 +1179,76 @@ public:
         }
     }
   public:
-    enum { NBGO = TeleInfoCount + sizeof(mGO)/sizeof(uint16_t), SIZEPARAMS = sizeof(mParams) };
+    enum { NBGO = TeleInfoCount + (sizeof(mGO) + sizeof(mCompoundGO) + sizeof(mPeriodGO))/sizeof(uint16_t), SIZEPARAMS = sizeof(mParams) };
 };
-uint8_t teleinfoHolder[sizeof(TeleInfo)] __attribute__ ((section (".noinit")));
-TeleInfo& teleinfo = *(TeleInfo*)teleinfoHolder;
+TeleInfo teleinfo;
+
+// Restore ram after a reset without power loss (software, watchdog, reset pin): the snapshot is only trusted if its version and CRC match
+struct WarmStart {
+    uint32_t version;
+    RTCKnx::Snapshot rtc;
+    TeleInfo::Snapshot teleinfo;
+    uint32_t crc;
+} warmStart __attribute__ ((section (".noinit")));
+static const uint32_t WarmStartVersion = ((uint32_t)WARMSTART_VERSION << 16) | sizeof(WarmStart);
+static_assert(offsetof(WarmStart, crc) % sizeof(uint32_t) == 0, "The CRC must cover the whole snapshot (32-bit words)");
+
+static uint32_t crc32(const void* data, size_t size) {
+    // Hardware CRC unit (CRC-32 Ethernet polynomial), size must be a multiple of 4
+    __HAL_RCC_CRC_CLK_ENABLE();
+    CRC->CR = CRC_CR_RESET;
+    for (const uint32_t* word = (const uint32_t*)data; size >= sizeof(uint32_t); size -= sizeof(uint32_t)) {
+        CRC->DR = *word++;
+    }
+    return CRC->DR;
+}
+static inline uint32_t warmStartCrc() { return crc32(&warmStart, offsetof(WarmStart, crc)); }
+static inline bool warmStartValid() { return warmStart.version == WarmStartVersion && warmStart.crc == warmStartCrc(); }
+// After a power-on or brownout reset, the time spent without power is unknown: the snapshot (clock, tariff window) is stale
+static bool powerLossReset() {
+    const bool powerLoss = __HAL_RCC_GET_FLAG(RCC_FLAG_BORRST) != RESET;
+    __HAL_RCC_CLEAR_RESET_FLAGS();  // Flags are kept until cleared: the next reset is identified alone
+    return powerLoss;
+}
+static void warmStartSave() {
+    warmStart.version = 0;  // Invalid while being written
+    rtc.snapshot(warmStart.rtc);
+    teleinfo.snapshot(warmStart.teleinfo);
+    warmStart.version = WarmStartVersion;
+    warmStart.crc = warmStartCrc();
+}
 
 extern "C" void SystemClock_Config(void)
 {
-    // Nothing for default 4MHz MSI Clock
-    // Required to downclock the 80MHz clock to be below 4096 * 16 * 1200 (TeleInfo BaudRate) due to limitation in UART_BRR 12bit register
+    // Core stays on MSI (4MHz at reset)
+    // UARTs are clocked from HSI16: 1200 bauds (TeleInfo) is reachable whatever the core clock, despite the 12bit UART_BRR mantissa
+    __HAL_RCC_HSI_ENABLE();
+    while (__HAL_RCC_GET_FLAG(RCC_FLAG_HSIRDY) == RESET) {}
+    __HAL_RCC_USART1_CONFIG(RCC_USART1CLKSOURCE_HSI);   // TPUART
+    __HAL_RCC_USART2_CONFIG(RCC_USART2CLKSOURCE_HSI);   // TeleInfo
+    __HAL_RCC_MSI_RANGE_CONFIG(CLOCK_MSIRANGE);
+    SystemCoreClockUpdate();
+}
+
+// History bulk export through a function property command
+// Request: offset - Response: return code, snapshot sequence, offset, export size (offset 0 only), data chunk (empty after the end)
+static bool historyExportCallback(uint8_t objectIndex, uint8_t propertyId, uint8_t length, uint8_t* data, uint8_t* resultData, uint8_t& resultLength) {
+    if (objectIndex != HISTORY_EXPORT_OBJECT_INDEX || propertyId != HISTORY_EXPORT_PROPERTY_ID || length < 1 || resultLength < 4)
+        return false;
+    resultData[0] = 0;  // Success
+    resultData[2] = data[0];
+    uint8_t header = 3;
+    if (data[0] == 0) {
+        resultData[header++] = TeleInfo::EXPORT_SIZE;   // The client stops at the end, without requesting past it
+    }
+    // HISTORY_EXPORT_CHUNK_SIZE is the data size after a 3 bytes header
+    resultLength = header + teleinfo.exportHistory(data[0], resultData + header, MIN(resultLength - header, HISTORY_EXPORT_CHUNK_SIZE + 3 - header), resultData[1]);
+    return true;
 }
 
 static HardwareSerial serialTpuart(PIN_TPUART_TX, PIN_TPUART_RX);
 void setup()
 {
-    if (Inited != INIT_MASK) {
-        new (&rtc) RTCKnx();
-        new (&teleinfo) TeleInfo();
-        Inited = INIT_MASK;
-    }
-
     knx.platform().knxUart(&serialTpuart);
     knx.ledPin(PIN_PROG_LED);
     knx.ledPinActiveOn(HIGH);
@@ -801,7 +1268,12 @@ void setup()
     if (knx.configured()) {
         rtc.init(0, 0);
         teleinfo.init(RTCKnx::SIZEPARAMS, RTCKnx::NBGO);
+        if (!powerLossReset() && warmStartValid()) { // Otherwise history is restored from flash
+            rtc.restore(warmStart.rtc);
+            teleinfo.restore(warmStart.teleinfo);
+        }
         rtc.setNotifier(std::bind(&TeleInfo::newDate, &teleinfo, std::placeholders::_1));
+        knx.bau().functionPropertyCallback(historyExportCallback);
         // attachInterrupt(PIN_TPUART_SAVE, std::bind(&TeleInfo::saveHistory, &teleinfo), LOW);    // 2ms to save history before shutdown - likely not enough
     }
 
@@ -821,6 +1293,23 @@ void loop()
     }
 
     uint32_t currentMillis = rtc.millis();
+    // Republish current state when the bus comes back (bus power restored, TPUART reset)
+    // The bus coming up after knx.start() is not a recovery: only once it has been seen enabled
+    static bool busSeen = false, busEnabled = false;
+    const bool enabled = knx.bau().enabled();
+    if (knx.configured() && enabled && busSeen && !busEnabled) {
+        rtc.requestSync();
+        teleinfo.republish();
+    }
+    busEnabled = enabled;
+    busSeen |= enabled;
+
+    // Refresh warm start snapshot
+    static uint32_t warmStartTimer = 0;
+    if (knx.configured() && currentMillis - warmStartTimer > WARMSTART_SNAPSHOT_PERIOD) {
+        warmStartSave();
+        warmStartTimer = currentMillis;
+    }
     // Handle Reset History by long prog button press
     static uint32_t progButtonPressedTimer = 0;
     static bool historyReset = false;
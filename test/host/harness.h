@@ -0,0 +1,89 @@
+/*
+ * TeleInfo KNX - Host test harness
+ *  The firmware is compiled on the host against the stubs, the tests drive it through setup()/loop()
+ */
+#pragma once
+
+#include "../../src/main.cpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define CHECK(cond) do { if (!(cond)) { fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); exit(1); } } while (0)
+
+namespace host {
+    // Group objects numbering (see README)
+    enum { GO_DATE = 1, GO_TIME, GO_DATETIME, GO_HISTORY = 7, GO_TIC = 25, GO_COMPOUND_CURRENTS = 54, GO_COMPOUND_TARIFF,
+           GO_PERIOD_CURRENT = 58, GO_PERIOD_PREVIOUS, GO_PERIOD_TODAY };
+    inline uint16_t historyGO(int tariff, int period) { return GO_HISTORY + tariff * 6 + period; }
+    inline uint16_t ticGO(const char* key) {
+        for (unsigned int i = 0; i < TeleInfoCount; ++i) {
+            if (strncmp(TeleInfoParam[i].key, key, strlen(key)) == 0 && TeleInfoParam[i].key[strlen(key)] == ' ') return GO_TIC + i;
+        }
+        abort();
+    }
+
+    // TeleInfo line: LF label SP data SP checksum CR
+    inline std::string ticLine(const std::string& label, const std::string& data) {
+        const std::string payload = label + " " + data;
+        uint8_t sum = 0;
+        for (char c : payload) sum += (uint8_t)c;
+        return "\n" + payload + " " + (char)((sum & 0x3F) + 0x20) + "\r";
+    }
+    inline std::string ticFrame(const std::vector<std::pair<std::string, std::string>>& lines) {
+        std::string frame = "\x02";
+        for (const auto& line : lines) frame += ticLine(line.first, line.second);
+        return frame + "\x03";
+    }
+    inline std::string index(uint32_t value) { char text[10]; snprintf(text, sizeof(text), "%09u", value); return text; }
+    inline void feed(const std::string& bytes) {
+        std::deque<uint8_t>& rx = serial(PIN_TELE_RX);
+        rx.insert(rx.end(), bytes.begin(), bytes.end());
+    }
+    // Bytes received at the TeleInfo line rate (1200 bauds 7E1: 120 bytes/s), the main loop running every stepUs
+    inline void feedAtLineRate(const std::string& bytes, uint32_t stepUs = 1000) {
+        for (char c : bytes) {
+            feed(std::string(1, c));
+            for (const uint64_t end = now + 1000000 / 120; now < end; now += stepUs) {
+                loop();
+            }
+        }
+    }
+
+    // Device parameters (ETS): time sync period (min), emission period (s), real time timeout (min), compound objects
+    inline void configure(uint32_t syncPeriod = 60, uint32_t period = 0, uint32_t realTimeTimeout = 15, bool compound = false) {
+        setParam(0, syncPeriod); setParam(4, period); setParam(8, realTimeTimeout); setParam(12, compound);
+    }
+
+    // Reset of the MCU: RAM is lost (except .noinit warm start snapshot), flash is kept
+    // Note: function static variables of loop() are not reset
+    inline void boot() {
+        now = 0;
+        sent.clear(); readRequests.clear();
+        serial(PIN_TELE_RX).clear();
+        resetGroupObjects();
+        rtc.~RTCKnx(); new (&rtc) RTCKnx();
+        teleinfo.~TeleInfo(); new (&teleinfo) TeleInfo();
+        setup();
+    }
+    // Run the main loop for a duration, advancing time by step at each call
+    inline void run(uint32_t ms, uint32_t stepUs = 1000) {
+        for (const uint64_t end = now + (uint64_t)ms * 1000; now < end; now += stepUs) {
+            loop();
+        }
+    }
+    // Answer the date/time requested on the bus
+    inline void setDateTime(int year, int month, int day, int hour, int minute, int second) {
+        struct tm dateTime = {};
+        dateTime.tm_year = year; dateTime.tm_mon = month; dateTime.tm_mday = day;
+        dateTime.tm_hour = hour; dateTime.tm_min = minute; dateTime.tm_sec = second;
+        write(GO_DATETIME, dateTime);
+    }
+    inline size_t sentCount(uint16_t goNr) {
+        size_t count = 0;
+        for (const Telegram& telegram : sent) count += telegram.go == goNr;
+        return count;
+    }
+}
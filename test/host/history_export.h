@@ -0,0 +1,77 @@
+/*
+ * TeleInfo KNX - Host test harness
+ *  Client side of the history export (function property command), layout in README
+ */
+#pragma once
+
+#include "harness.h"
+
+namespace host {
+    struct HistoryExport {
+        uint8_t version;
+        uint8_t tariffCount;
+        struct { uint16_t year; uint8_t month, day, hour, minute, second; } lastSave;
+        struct { uint32_t index, yesterday, lastMonth, lastYear, dayM2, monthM2, yearM2; } tariff[3];
+        uint32_t flashWrites;       // Version 2
+        struct { uint32_t switches, boostTime, idleTime; } clock;   // Version 3
+    };
+
+    // One function property command: return the chunk length, -1 on error (export size in the response of offset 0)
+    inline int exportChunk(uint8_t offset, uint8_t& sequence, uint8_t* chunk, uint8_t* size = nullptr) {
+        uint8_t result[0xff];
+        uint8_t resultLength = sizeof(result);  // Buffer size given by the stack
+        if (functionProperty == nullptr || !functionProperty(HISTORY_EXPORT_OBJECT_INDEX, HISTORY_EXPORT_PROPERTY_ID, 1, &offset, result, resultLength)) return -1;
+        const uint8_t header = offset == 0 ? 4 : 3;
+        if (resultLength < header || result[0] != 0 || result[2] != offset) return -1;
+        sequence = result[1];
+        if (offset == 0 && size) *size = result[3];
+        memcpy(chunk, result + header, resultLength - header);
+        return resultLength - header;
+    }
+
+    // Read the whole export chunk by chunk until its size, restart if the snapshot changed during the transfer
+    inline bool readHistoryExport(std::vector<uint8_t>& raw, int* requests = nullptr) {
+        for (int attempt = 0; attempt < 3; ++attempt) {
+            raw.clear();
+            uint8_t sequence = 0, chunkSequence, chunk[0xff], size = 0;
+            int length;
+            do {
+                length = exportChunk((uint8_t)raw.size(), chunkSequence, chunk, &size);
+                if (requests) ++*requests;
+                if (length <= 0) break;
+                if (raw.empty()) sequence = chunkSequence;
+                else if (chunkSequence != sequence) break;
+                raw.insert(raw.end(), chunk, chunk + length);
+            } while (raw.size() < size);
+            if (length < 0) return false;
+            if (chunkSequence == sequence && !raw.empty() && raw.size() == size) return true;
+        }
+        return false;
+    }
+
+    // Fields are only appended by new versions: an older client decodes the beginning of a newer export
+    inline bool decodeHistoryExport(const std::vector<uint8_t>& raw, HistoryExport& result) {
+        size_t pos = 0;
+        auto read = [&](int size) {
+            uint32_t value = 0;
+            for (int i = 0; i < size; ++i) value = (value << 8) | (pos < raw.size() ? raw[pos] : 0), ++pos;
+            return value;
+        };
+        result.version = read(1);
+        result.tariffCount = read(1);
+        if (result.version < 1 || result.tariffCount != 3) return false;
+        result.lastSave.year = read(2);
+        result.lastSave.month = read(1); result.lastSave.day = read(1);
+        result.lastSave.hour = read(1); result.lastSave.minute = read(1); result.lastSave.second = read(1);
+        for (auto& tariff : result.tariff) {
+            tariff.index = read(4); tariff.yesterday = read(4); tariff.lastMonth = read(4); tariff.lastYear = read(4);
+            tariff.dayM2 = read(4); tariff.monthM2 = read(4); tariff.yearM2 = read(4);
+        }
+        result.flashWrites = result.version >= 2 ? read(4) : 0;
+        result.clock = {};
+        if (result.version >= 3) {
+            result.clock.switches = read(4); result.clock.boostTime = read(4); result.clock.idleTime = read(4);
+        }
+        return pos <= raw.size();
+    }
+}
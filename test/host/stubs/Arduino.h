@@ -0,0 +1,99 @@
+/*
+ * TeleInfo KNX - Host test stubs
+ *  Minimal Arduino STM32 core (time, GPIO, UART, buffered EEPROM, HAL) simulated on the host
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <ctime>
+#include <deque>
+#include <functional>
+
+#define PROGMEM
+#define PSTR(s)                             (s)
+#ifndef MIN
+#define MIN(a,b)                            ((a)<(b)?(a):(b))
+#endif
+
+#define LOW                                 0
+#define HIGH                                1
+#define RISING                              3
+#define SERIAL_7E1                          0x2a
+
+enum { PA2 = 2, PA3 = 3, PA4 = 4, PB3 = 19, PB4 = 20, PB5 = 21, PB6 = 22, PB7 = 23 };
+
+#ifndef KNX_FLASH_SIZE
+#define KNX_FLASH_SIZE                      1024
+#endif
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE               256
+#endif
+#define E2END                               2047    // One flash page
+
+namespace host {
+    extern uint64_t now;            // Simulated time since reset (us)
+    extern int pins[32];            // Level read by digitalRead, last level written by digitalWrite
+    extern uint8_t flash[E2END + 1];    // Emulated EEPROM page in flash
+    extern uint32_t flashErases;    // Page erase/program cycles
+    extern uint32_t clockUpdates;   // SystemCoreClockUpdate() calls
+    extern bool powerLoss;          // Reset flag of a power-on or brownout reset (RCC_FLAG_BORRST), cleared by the firmware
+    std::deque<uint8_t>& serial(uint32_t rxPin);    // Bytes waiting on a UART
+}
+
+uint32_t millis();
+uint32_t micros();
+int digitalRead(uint32_t pin);
+void digitalWrite(uint32_t pin, uint32_t value);
+
+class HardwareSerial
+{
+  public:
+    HardwareSerial(uint32_t rx, uint32_t tx) : mRx(rx) { (void)tx; }
+    void begin(uint32_t baud, uint8_t config = 0) { (void)baud; (void)config; }
+    int available() { return (int)MIN(host::serial(mRx).size(), (size_t)SERIAL_RX_BUFFER_SIZE - 1); }
+    int read();
+  private:
+    uint32_t mRx;
+};
+
+// Buffered EEPROM emulation (stm32duino core)
+uint8_t eeprom_buffered_read_byte(uint32_t pos);
+void eeprom_buffered_write_byte(uint32_t pos, uint8_t value);
+void eeprom_buffer_fill();
+void eeprom_buffer_flush();
+
+// HAL: clock tree configuration is not simulated
+#define RESET                               0
+#define RCC_MSIRANGE_6                      6
+#define RCC_FLAG_HSIRDY                     1
+#define RCC_FLAG_BORRST                     2
+#define RCC_USART1CLKSOURCE_HSI             2
+#define RCC_USART2CLKSOURCE_HSI             2
+#define __HAL_RCC_MSI_RANGE_CONFIG(x)       ((void)(x))
+#define __HAL_RCC_HSI_ENABLE()              ((void)0)
+#define __HAL_RCC_GET_FLAG(x)               ((x) == RCC_FLAG_BORRST ? host::powerLoss : 1)
+#define __HAL_RCC_CLEAR_RESET_FLAGS()       (host::powerLoss = false)
+#define __HAL_RCC_USART1_CONFIG(x)          ((void)(x))
+#define __HAL_RCC_USART2_CONFIG(x)          ((void)(x))
+#define __HAL_RCC_CRC_CLK_ENABLE()          ((void)0)
+void SystemCoreClockUpdate();
+
+// CRC unit: CRC-32 (0x04C11DB7), 32-bit words fed MSB first, reset to 0xFFFFFFFF
+#define CRC_CR_RESET                        1U
+struct HostCrcUnit {
+    struct Control {
+        HostCrcUnit& unit;
+        void operator=(uint32_t value) { if (value & CRC_CR_RESET) unit.crc = 0xFFFFFFFF; }
+    } CR{*this};
+    struct Data {
+        HostCrcUnit& unit;
+        void operator=(uint32_t word);
+        operator uint32_t() const { return unit.crc; }
+    } DR{*this};
+    uint32_t crc = 0xFFFFFFFF;
+};
+extern HostCrcUnit hostCrcUnit;
+#define CRC                                 (&hostCrcUnit)
@@ -0,0 +1,185 @@
+/*
+ * TeleInfo KNX - Host test stubs
+ */
+#include <Arduino.h>
+#include <knx.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <sstream>
+
+namespace host {
+    uint64_t now = 0;
+    int pins[32] = {0};
+    uint8_t flash[E2END + 1];
+    uint32_t flashErases = 0;
+    uint32_t clockUpdates = 0;
+    bool powerLoss = true;      // Power on
+    std::vector<Telegram> sent;
+    std::vector<uint16_t> readRequests;
+    bool configured = true;
+    bool busEnabled = true;
+    bool progMode = false;
+    uint16_t individualAddress = 0x1101;
+    uint8_t params[64] = {0};
+    uint16_t groupObjectCount = 0;
+    FunctionPropertyCallback functionProperty = nullptr;
+
+    static uint8_t eepromBuffer[E2END + 1];
+    static const struct FlashInit { FlashInit() { memset(flash, 0xff, sizeof(flash)); memset(eepromBuffer, 0xff, sizeof(eepromBuffer)); } } flashInit;
+
+    std::deque<uint8_t>& serial(uint32_t rxPin) {
+        static std::map<uint32_t, std::deque<uint8_t>> uarts;
+        return uarts[rxPin];
+    }
+
+    void setParam(uint32_t addr, uint32_t value) {
+        for (int i = 3; i >= 0; --i, value >>= 8) params[addr + i] = (uint8_t)value;
+    }
+
+    // Object sizes parsed once from the ETS database (the source of truth for group object sizes)
+    static const std::map<uint16_t, uint8_t>& etsObjectSizes() {
+        static std::map<uint16_t, uint8_t> sizes;
+        if (sizes.empty()) {
+            std::ifstream file(TELEINFO_ETS_XML);
+            if (!file) {
+                fprintf(stderr, "Cannot open %s\n", TELEINFO_ETS_XML);
+                exit(2);
+            }
+            std::stringstream xml; xml << file.rdbuf();
+            const std::string content = xml.str();
+            const std::regex comObject("<ComObject [^>]*Number=\"([0-9]+)\"[^>]*ObjectSize=\"([0-9]+) (Bit|Byte|Bytes)\"");
+            for (std::sregex_iterator it(content.begin(), content.end(), comObject), end; it != end; ++it) {
+                sizes[(uint16_t)std::stoi((*it)[1])] = (*it)[3] == "Bit" ? 1 : (uint8_t)std::stoi((*it)[2]);
+            }
+        }
+        return sizes;
+    }
+    uint8_t etsObjectSize(uint16_t goNr) {
+        const auto& sizes = etsObjectSizes();
+        const auto it = sizes.find(goNr);
+        return it != sizes.end() ? it->second : 0;
+    }
+}
+
+struct HostGroupObjects {
+    std::vector<GroupObject> objects;
+    GroupObject& get(uint16_t goNr) {
+        if (objects.empty()) reset();
+        if (goNr == 0 || goNr >= objects.size() || goNr > knx.bau().groupObjectTable().entryCount()) {
+            fprintf(stderr, "Group object %u is not defined in the ETS database\n", goNr);
+            abort();
+        }
+        return objects[goNr];
+    }
+    static void notify(GroupObject& go) { if (go.mCallback) go.mCallback(go); }
+    void reset() {
+        objects.assign(host::etsObjectSizes().rbegin()->first + 1, GroupObject());
+        for (uint16_t i = 0; i < objects.size(); ++i) {
+            objects[i].mAsap = i;
+            objects[i].mSize = host::etsObjectSize(i);
+        }
+    }
+} hostGroupObjects;
+
+uint16_t GroupObjectTableObject::entryCount() { return host::groupObjectCount != 0 ? host::groupObjectCount : host::etsObjectSizes().rbegin()->first; }
+
+void host::resetGroupObjects() { hostGroupObjects.reset(); }
+void host::write(uint16_t goNr, const KNXValue& value) {
+    GroupObject& go = hostGroupObjects.get(goNr);
+    go.valueNoSend(value);
+    HostGroupObjects::notify(go);
+}
+uint32_t host::decode(uint16_t goNr) {
+    GroupObject& go = hostGroupObjects.get(goNr);
+    uint32_t value = 0;
+    for (size_t i = 0; i < go.valueSize() && i < sizeof(value); ++i) value = (value << 8) | go.valueRef()[i];
+    return value;
+}
+
+KNXValue GroupObject::value() {
+    switch (mDpt.mainGroup) {
+        case 10: case 11: case 19: return KNXValue(mTime);
+        case 1: return KNXValue(mData[0] != 0);
+        default: {
+            uint32_t value = 0;
+            for (size_t i = 0; i < mSize && i < sizeof(value); ++i) value = (value << 8) | mData[i];
+            return KNXValue(value);
+        }
+    }
+}
+void GroupObject::valueNoSend(const KNXValue& value) {
+    switch (mDpt.mainGroup) {
+        case 10: case 11: case 19: mTime = value; break;
+        case 1: mData[0] = (bool)value; break;
+        case 14: {
+            const float f = (float)(uint32_t)value;
+            uint32_t raw; memcpy(&raw, &f, sizeof(raw));
+            for (int i = 3; i >= 0; --i, raw >>= 8) mData[i] = (uint8_t)raw;
+        }; break;
+        default: {
+            uint32_t raw = value;
+            for (int i = mSize - 1; i >= 0; --i, raw >>= 8) mData[i] = (uint8_t)raw;
+        }
+    }
+}
+void GroupObject::objectWritten() {
+    host::sent.push_back({ host::now, mAsap, std::vector<uint8_t>(mData, mData + mSize) });
+}
+void GroupObject::requestObjectRead() { host::readRequests.push_back(mAsap); }
+
+void DeviceObject::individualAddress(uint16_t value) { (void)value; }
+bool Bau::enabled() { return host::busEnabled; }
+void Bau::functionPropertyCallback(FunctionPropertyCallback callback) { host::functionProperty = callback; }
+
+KnxFacade knx;
+GroupObject& KnxFacade::getGroupObject(uint16_t goNr) { return hostGroupObjects.get(goNr); }
+uint32_t KnxFacade::paramInt(uint32_t addr) {
+    return ((uint32_t)host::params[addr] << 24) | ((uint32_t)host::params[addr + 1] << 16) | ((uint32_t)host::params[addr + 2] << 8) | host::params[addr + 3];
+}
+void KnxFacade::readMemory() { eeprom_buffer_fill(); }
+bool KnxFacade::configured() { return host::configured; }
+bool KnxFacade::progMode() { return host::progMode; }
+void KnxFacade::progMode(bool value) { host::progMode = value; }
+uint16_t KnxFacade::individualAddress() { return host::individualAddress; }
+
+uint32_t millis() { return (uint32_t)(host::now / 1000); }
+uint32_t micros() { return (uint32_t)host::now; }
+int digitalRead(uint32_t pin) { return host::pins[pin % 32]; }
+void digitalWrite(uint32_t pin, uint32_t value) { host::pins[pin % 32] = (int)value; }
+
+int HardwareSerial::read() {
+    std::deque<uint8_t>& rx = host::serial(mRx);
+    if (rx.empty()) return -1;
+    const uint8_t c = rx.front();
+    rx.pop_front();
+    return c;
+}
+
+uint8_t eeprom_buffered_read_byte(uint32_t pos) { return host::eepromBuffer[pos]; }
+void eeprom_buffered_write_byte(uint32_t pos, uint8_t value) { host::eepromBuffer[pos] = value; }
+void eeprom_buffer_fill() { memcpy(host::eepromBuffer, host::flash, sizeof(host::flash)); }
+void eeprom_buffer_flush() {
+    memcpy(host::flash, host::eepromBuffer, sizeof(host::flash));
+    ++host::flashErases;
+}
+
+void SystemCoreClockUpdate() { ++host::clockUpdates; }
+
+HostCrcUnit hostCrcUnit;
+void HostCrcUnit::Data::operator=(uint32_t word) {
+    static uint32_t table[256];
+    if (table[1] == 0) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i << 24;
+            for (int j = 0; j < 8; ++j) crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+            table[i] = crc;
+        }
+    }
+    uint32_t crc = unit.crc;
+    for (int shift = 24; shift >= 0; shift -= 8) crc = (crc << 8) ^ table[((crc >> 24) ^ (word >> shift)) & 0xff];
+    unit.crc = crc;
+}
@@ -0,0 +1,145 @@
+/*
+ * TeleInfo KNX - Host test stubs
+ *  Subset of the knx stack used by the firmware: group objects sized from the ETS database, parameters, bau
+ *  Telegrams are recorded instead of being sent on the bus
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <vector>
+
+struct Dpt {
+    Dpt(short mainGroup = 0, short subGroup = 0, short index = 0) : mainGroup(mainGroup), subGroup(subGroup), index(index) {}
+    short mainGroup;
+    short subGroup;
+    short index;
+};
+#define DPT_Switch                          Dpt(1, 1)
+#define DPT_Char_ASCII                      Dpt(4, 1)
+#define DPT_Value_1_Ucount                  Dpt(5, 10)
+#define DPT_Value_2_Ucount                  Dpt(7, 1)
+#define DPT_TimePeriodMin                   Dpt(7, 6)
+#define DPT_Date                            Dpt(11, 1)
+#define DPT_Value_2_Count                   Dpt(13, 1)
+#define DPT_ActiveEnergy                    Dpt(13, 10)
+#define DPT_Value_Electric_Current          Dpt(14, 19)
+#define DPT_Value_Power                     Dpt(14, 56)
+#define DPT_String_ASCII                    Dpt(16, 0)
+#define DPT_DateTime                        Dpt(19, 1)
+
+class KNXValue
+{
+  public:
+    KNXValue(bool value) : mInt(value) {}
+    KNXValue(uint32_t value) : mInt(value) {}
+    KNXValue(struct tm value) : mInt(0), mTime(value) {}
+    operator bool() const { return mInt != 0; }
+    operator uint32_t() const { return (uint32_t)mInt; }
+    operator struct tm() const { return mTime; }
+  private:
+    uint64_t mInt;
+    struct tm mTime = {};
+};
+
+class GroupObject
+{
+  public:
+    void dataPointType(Dpt dpt) { mDpt = dpt; }
+    Dpt dataPointType() const { return mDpt; }
+    void callback(std::function<void(GroupObject&)> callback) { mCallback = callback; }
+    KNXValue value();
+    void value(const KNXValue& value) { valueNoSend(value); objectWritten(); }
+    void valueNoSend(const KNXValue& value);
+    void objectWritten();
+    void requestObjectRead();
+    uint8_t* valueRef() { return mData; }
+    size_t valueSize() { return mSize; }
+    uint16_t asap() const { return mAsap; }
+  private:
+    friend struct HostGroupObjects;
+    uint16_t mAsap = 0;
+    uint8_t mSize = 0;
+    uint8_t mData[14] = {0};
+    struct tm mTime = {};
+    Dpt mDpt;
+    std::function<void(GroupObject&)> mCallback;
+};
+
+typedef bool (*FunctionPropertyCallback)(uint8_t objectIndex, uint8_t propertyId, uint8_t length, uint8_t* data, uint8_t* resultData, uint8_t& resultLength);
+
+class DeviceObject
+{
+  public:
+    void individualAddress(uint16_t value);
+};
+class GroupObjectTableObject
+{
+  public:
+    uint16_t entryCount();
+};
+class Bau
+{
+  public:
+    bool enabled();
+    void functionPropertyCallback(FunctionPropertyCallback callback);
+    DeviceObject& deviceObject() { return mDeviceObject; }
+    GroupObjectTableObject& groupObjectTable() { return mGroupObjectTable; }
+  private:
+    DeviceObject mDeviceObject;
+    GroupObjectTableObject mGroupObjectTable;
+};
+class Platform
+{
+  public:
+    void knxUart(HardwareSerial* serial) { (void)serial; }
+};
+
+class KnxFacade
+{
+  public:
+    GroupObject& getGroupObject(uint16_t goNr);
+    uint32_t paramInt(uint32_t addr);
+    Bau& bau() { return mBau; }
+    Platform& platform() { return mPlatform; }
+    void ledPin(uint32_t pin) { (void)pin; }
+    void ledPinActiveOn(uint32_t value) { (void)value; }
+    void buttonPin(uint32_t pin) { (void)pin; }
+    void buttonPinInterruptOn(uint32_t mode) { (void)mode; }
+    void version(uint16_t value) { (void)value; }
+    void orderNumber(const uint8_t* value) { (void)value; }
+    void hardwareType(const uint8_t* value) { (void)value; }
+    void readMemory();
+    bool configured();
+    void start() {}
+    void loop() {}
+    bool progMode();
+    void progMode(bool value);
+    uint16_t individualAddress();
+  private:
+    Bau mBau;
+    Platform mPlatform;
+};
+extern KnxFacade knx;
+
+namespace host {
+    struct Telegram {
+        uint64_t time;              // us
+        uint16_t go;
+        std::vector<uint8_t> payload;
+    };
+    extern std::vector<Telegram> sent;  // Group value writes/responses emitted by the device
+    extern std::vector<uint16_t> readRequests;
+    extern bool configured;
+    extern bool busEnabled;
+    extern bool progMode;
+    extern uint16_t individualAddress;
+    extern uint8_t params[64];      // Parameter segment (big endian values)
+    extern uint16_t groupObjectCount;   // Group objects loaded by ETS, 0: all the objects of the ETS database
+    extern FunctionPropertyCallback functionProperty;
+
+    void setParam(uint32_t addr, uint32_t value);
+    uint8_t etsObjectSize(uint16_t goNr);   // ObjectSize of the ETS database in bytes, 0 if undefined
+    void resetGroupObjects();       // RAM lost at reset
+    void write(uint16_t goNr, const KNXValue& value);   // Group value write from the bus
+    uint32_t decode(uint16_t goNr); // Big endian payload of a group object
+}
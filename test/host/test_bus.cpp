@@ -0,0 +1,31 @@
+/*
+ * TeleInfo KNX - Host test
+ *  Bus recovery: state republished when the bus comes back, not when it comes up after the start
+ *  Note: the bus state seen by loop() is not reset by boot(), the start is checked first
+ */
+#include "harness.h"
+
+using namespace host;
+
+static const uint16_t GO_REALTIME_STATE = 6;   // First group object of each republish sequence
+
+int main() {
+    configure();
+    busEnabled = false;     // TPUART not ready yet
+    boot();
+    feed(ticFrame({ { "OPTARIF", "BASE" }, { "BASE", index(1234567) }, { "PTEC", "TH.." } }));
+    run(2000);
+    busEnabled = true;
+    readRequests.clear();
+    run(REPUBLISH_SPREAD + 2000);
+    CHECK(sentCount(GO_REALTIME_STATE) == 0 && readRequests.empty());
+
+    // Bus power cut and restored
+    busEnabled = false;
+    run(1000);
+    busEnabled = true;
+    run(REPUBLISH_SPREAD + 2000);
+    CHECK(sentCount(GO_REALTIME_STATE) == 1 && !readRequests.empty());
+    CHECK(sentCount(ticGO("BASE")) == 2);   // Frame, then republish
+    return 0;
+}
@@ -0,0 +1,50 @@
+/*
+ * TeleInfo KNX - Host test
+ *  Compound group objects: sent once per frame, whereas the lines of a frame are parsed in different loops
+ *  Product database before application version 17 (53 group objects): no compound nor tariff period group object
+ */
+#include "harness.h"
+
+using namespace host;
+
+int main() {
+    configure(60, 0, 15, true);
+    boot();
+    setDateTime(2026, 3, 10, 12, 0, 0);
+    run(1000);
+
+    // Three phase meter, all the currents change at each frame: bytes at the line rate
+    const int frames = 5;
+    for (int i = 0; i < frames; ++i) {
+        char current[4];
+        snprintf(current, sizeof(current), "%03d", 10 + i);
+        feedAtLineRate(ticFrame({ { "ADCO", "012345678901" }, { "OPTARIF", "BASE" }, { "ISOUSC", "30" }, { "BASE", index(1000000 + 10 * i) }, { "PTEC", "TH.." },
+                                  { "IINST1", current }, { "IINST2", current }, { "IINST3", current }, { "PMAX", "03000" }, { "PAPP", "00450" } }));
+    }
+    CHECK(sentCount(ticGO("IINST1")) == frames && sentCount(ticGO("IINST3")) == frames);
+    CHECK(sentCount(GO_COMPOUND_CURRENTS) == frames);
+    CHECK(sentCount(GO_COMPOUND_TARIFF) == frames);     // Base index
+    CHECK(decode(GO_COMPOUND_CURRENTS) == ((10u + frames - 1) << 16 | (10u + frames - 1)));  // IINST1, IINST2 (A)
+
+    // Same frame again: nothing changed, nothing emitted
+    sent.clear();
+    feedAtLineRate(ticFrame({ { "IINST1", "014" }, { "IINST2", "014" }, { "IINST3", "014" } }));
+    CHECK(sentCount(GO_COMPOUND_CURRENTS) == 0);
+
+    // Older product database: the compound parameter is past its parameter segment, GO 54 and above are not loaded
+    groupObjectCount = GO_COMPOUND_CURRENTS - 1;
+    powerLoss = true;
+    boot();
+    setDateTime(2026, 3, 10, 12, 0, 0);
+    for (int i = 0; i < frames; ++i) {
+        feedAtLineRate(ticFrame({ { "ADCO", "012345678901" }, { "OPTARIF", "HC.." }, { "ISOUSC", "30" }, { "HCHC", index(1000000 + 10 * i) },
+                                  { "HCHP", index(2000000) }, { "PTEC", i % 2 ? "HC.." : "HP.." }, { "IINST1", "010" }, { "IINST2", "011" }, { "IINST3", "012" } }));
+    }
+    run(WARMSTART_SNAPSHOT_PERIOD + 100);
+    boot();     // Warm start: republish
+    run(REPUBLISH_SPREAD + 100);
+    CHECK(sentCount(ticGO("HCHC")) > 0);
+    for (const Telegram& telegram : sent) CHECK(telegram.go < GO_COMPOUND_CURRENTS);
+    groupObjectCount = 0;
+    return 0;
+}
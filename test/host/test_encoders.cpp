@@ -0,0 +1,83 @@
+/*
+ * TeleInfo KNX - Host test
+ *  TIC encoders: payload size matches the ETS group object, first value received is emitted, tariff period after a cold start
+ *  and at a transition received at the line rate
+ */
+#include "harness.h"
+
+using namespace host;
+
+int main() {
+    // Encoded size of each TIC field is the size of its group object in the ETS database
+    for (unsigned int i = 0; i < TeleInfoCount; ++i) {
+        const std::string field(TeleInfoParam[i].size, '0');
+        uint8_t payload[TELEINFO_PAYLOAD_MAXSIZE];
+        uint32_t value;
+        const uint8_t size = TeleInfoParam[i].encode(field.data(), field.data() + field.size(), value, payload);
+        if (size != etsObjectSize(GO_TIC + i)) {
+            fprintf(stderr, "%s: encoded %u bytes, group object %u is %u bytes\n", TeleInfoParam[i].key, size, GO_TIC + i, etsObjectSize(GO_TIC + i));
+            return 1;
+        }
+    }
+
+    // Base contract: all enum fields encode to 0, they are emitted anyway
+    configure();
+    boot();
+    feed(ticFrame({ { "ADCO", "012345678901" }, { "OPTARIF", "BASE" }, { "ISOUSC", "30" }, { "BASE", index(1234567) },
+                    { "PTEC", "TH.." }, { "IINST", "005" }, { "IMAX", "090" }, { "PAPP", "01150" }, { "HHPHC", "A" } }));
+    run(2000);
+    CHECK(sentCount(ticGO("OPTARIF")) == 1 && decode(ticGO("OPTARIF")) == 0);
+    CHECK(sentCount(ticGO("PTEC")) == 1 && decode(ticGO("PTEC")) == 0);
+    CHECK(sentCount(ticGO("PAPP")) == 1 && decode(ticGO("PAPP")) == 1150);
+    CHECK(decode(ticGO("BASE")) == 1234567);
+
+    // Same frame again: nothing changed, nothing emitted
+    sent.clear();
+    feed(ticFrame({ { "OPTARIF", "BASE" }, { "BASE", index(1234567) }, { "PTEC", "TH.." }, { "PAPP", "01150" } }));
+    run(2000);
+    CHECK(sentCount(ticGO("OPTARIF")) == 0 && sentCount(ticGO("PAPP")) == 0);
+
+    // History runs for Base once the time is known
+    setDateTime(2026, 3, 10, 12, 0, 0);
+    feed(ticFrame({ { "OPTARIF", "BASE" }, { "BASE", index(1234600) }, { "PTEC", "TH.." }, { "PAPP", "99999" } }));
+    run(2000);
+    CHECK(sentCount(historyGO(0, 0)) == 1);
+    CHECK(decode(ticGO("PAPP")) == 0xffff);    // Saturated to the 2 bytes DPT
+
+    // Checksum of a line can be a space
+    CHECK(ticLine("BASE", index(1234605)).rbegin()[1] == ' ');
+    feed(ticFrame({ { "BASE", index(1234605) } }));
+    run(2000);
+    CHECK(decode(ticGO("BASE")) == 1234605);
+
+    // Reset without power loss: the TIC values come back from the warm start snapshot
+    run(WARMSTART_SNAPSHOT_PERIOD + 100);
+    boot();
+    CHECK(decode(ticGO("BASE")) == 1234605);
+
+    // Cold start within a frame: the tariff period of the partial frame comes before any index
+    powerLoss = true;   // Power cut: the warm start snapshot is stale
+    boot();
+    CHECK(decode(ticGO("BASE")) == 0);
+    feed(ticLine("PTEC", "HP..") + "\x03");
+    run(2000);
+    feed(ticFrame({ { "OPTARIF", "HC.." }, { "HCHC", index(1000) }, { "HCHP", index(2000) }, { "PTEC", "HP.." } }));
+    run(2000);
+    CHECK(sentCount(GO_PERIOD_CURRENT) == 1 && decode(GO_PERIOD_CURRENT) == 0);
+    CHECK(sentCount(GO_PERIOD_TODAY) == 1 && sentCount(GO_PERIOD_TODAY + 1) == 1);
+    feed(ticFrame({ { "OPTARIF", "HC.." }, { "HCHC", index(1000) }, { "HCHP", index(2100) }, { "PTEC", "HP.." } }));
+    run(2000);
+    CHECK(decode(GO_PERIOD_CURRENT) == 100 && decode(GO_PERIOD_TODAY + 1) == 100);
+    CHECK(sentCount(GO_PERIOD_PREVIOUS) == 0);
+
+    // Peak to Off-Peak transition at the line rate, several loops per ms: the window is closed once, at the PTEC line
+    sent.clear();
+    feedAtLineRate(ticFrame({ { "OPTARIF", "HC.." }, { "HCHC", index(1000) }, { "HCHP", index(2700) }, { "PTEC", "HC.." } }), 100);
+    feedAtLineRate(ticFrame({ { "OPTARIF", "HC.." }, { "HCHC", index(1050) }, { "HCHP", index(2700) }, { "PTEC", "HC.." } }), 100);
+    CHECK(sentCount(GO_PERIOD_PREVIOUS) == 1 && decode(GO_PERIOD_PREVIOUS) == 700);
+    CHECK(decode(GO_PERIOD_CURRENT) == 50 && decode(GO_PERIOD_TODAY + 1) == 700);
+    // Today group objects only when their value changes: Peak today (700) is not sent again at the transition
+    CHECK(sentCount(GO_PERIOD_CURRENT) == 3);   // 700, 0 (new window), 50
+    CHECK(sentCount(GO_PERIOD_TODAY) == 1 && sentCount(GO_PERIOD_TODAY + 1) == 1);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ * TeleInfo KNX - Host test
+ *  History export: decoding, number of requests, clients reading concurrently
+ */
+#include "history_export.h"
+
+using namespace host;
+
+static void feedIndexes(uint32_t hc, uint32_t hp) {
+    feed(ticFrame({ { "OPTARIF", "HC.." }, { "HCHC", index(hc) }, { "HCHP", index(hp) }, { "PTEC", "HC.." } }));
+}
+
+int main() {
+    configure();
+    boot();
+    setDateTime(2026, 3, 10, 12, 0, 0);
+    feedIndexes(1000, 2000);
+    run(2000);
+
+    // Whole export, chunk size bounded by HISTORY_EXPORT_CHUNK_SIZE (minus the export size at offset 0), no request past the end
+    std::vector<uint8_t> raw;
+    int requests = 0;
+    CHECK(readHistoryExport(raw, &requests));
+    CHECK(raw.size() == TeleInfo::EXPORT_SIZE);
+    const int chunkSize = MIN(0xff - 3, HISTORY_EXPORT_CHUNK_SIZE);
+    CHECK(requests == (1 + TeleInfo::EXPORT_SIZE + chunkSize - 1) / chunkSize);
+    uint8_t sequence, chunk[0xff];
+    CHECK(exportChunk(TeleInfo::EXPORT_SIZE, sequence, chunk) == 0);   // Past the end: empty chunk
+    HistoryExport history;
+    CHECK(decodeHistoryExport(raw, history));
+    CHECK(history.version == HISTORY_EXPORT_VERSION);
+    CHECK(history.tariff[0].index == 3000 && history.tariff[1].index == 1000 && history.tariff[2].index == 2000);
+    CHECK(history.tariff[0].yesterday == 3000 && history.tariff[1].lastMonth == 1000 && history.tariff[2].lastYear == 2000);
+
+    // A client starting while another one reads gets the same snapshot
+    uint8_t sequenceA, sequenceB, chunkA[0xff], chunkB[0xff];
+    CHECK(exportChunk(0, sequenceA, chunkA) > 0);
+    const int length = exportChunk(9 /* Base index */, sequenceA, chunkA);
+    feedIndexes(1010, 2000);
+    run(1000);
+    CHECK(exportChunk(0, sequenceB, chunkB) > 0);
+    CHECK(exportChunk(9, sequenceB, chunkB) == length);
+    CHECK(sequenceA == sequenceB && memcmp(chunkA, chunkB, length) == 0);
+
+    // Afterwards, a new snapshot is taken: the first client sees the sequence change and restarts
+    run(HISTORY_EXPORT_HOLD + 1000);
+    CHECK(exportChunk(0, sequenceB, chunkB) > 0);
+    CHECK(sequenceB != sequenceA);
+    CHECK(exportChunk(TeleInfo::EXPORT_SIZE / 2, sequenceA, chunkA) > 0);
+    CHECK(sequenceA == sequenceB);
+    CHECK(readHistoryExport(raw) && decodeHistoryExport(raw, history));
+    CHECK(history.tariff[0].index == 3010 && history.tariff[1].index == 1010);
+
+    // Core clock: no switch, the time since boot is spent in the low power range
+    feedIndexes(1100, 2000);
+    run(75 * 60 * 1000, 100000);
+    CHECK(readHistoryExport(raw) && decodeHistoryExport(raw, history));
+    CHECK(history.clock.switches == 0 && history.clock.boostTime == 0);
+    CHECK(history.clock.idleTime <= now / 1000 && history.clock.idleTime + 1000 > now / 1000);
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * TeleInfo KNX - Host test
+ *  TeleInfo line handler fed with adversarial and random bytes: each loop parses at most TELEINFO_LOOP_MAXBYTES
+ *  and its work (bytes scanned, line bytes, label compares, bytes moved) is bounded, whatever the line content
+ *  libFuzzer target when built with TELEINFO_LIBFUZZER (clang -fsanitize=fuzzer), standalone driver otherwise:
+ *  test_fuzz [files...] runs the given inputs, the built-in corpus without argument
+ */
+#include <stddef.h>
+
+struct ParsingWork { size_t scanned, lines, compares, moved; };
+static ParsingWork work, maxWork;
+#define TELEINFO_WORK(counter, n)       (work.counter += (n))
+
+#include "harness.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace host;
+
+// Work bounds of a loop, independent of the host speed:
+// - only the new bytes are scanned for a CR
+// - each line is processed once (the lines are disjoint parts of the buffer and of the new bytes)
+// - labels are compared for lines with a valid checksum (2 spaces, checksum and CR: 4 bytes at least), all new bytes but the first line,
+//   at most TeleInfoCount compares each
+// - the incomplete line is moved once per read (2 reads when the buffer is full)
+static const ParsingWork workBound = { TELEINFO_LOOP_MAXBYTES, TELEINFO_BUFFERSIZE + TELEINFO_LOOP_MAXBYTES,
+                                       (1 + TELEINFO_LOOP_MAXBYTES / 4) * TeleInfoCount, 2 * TELEINFO_BUFFERSIZE };
+
+static void fuzzLine(const uint8_t* data, size_t size) {
+    configure();
+    boot();
+    setDateTime(2026, 3, 10, 12, 0, 0);
+    feed(std::string((const char*)data, size));
+    std::deque<uint8_t>& rx = serial(PIN_TELE_RX);
+    int idle = 0;   // Loops without progress (reset of a buffer full of dummies)
+    while (!rx.empty()) {
+        const size_t pending = rx.size();
+        work = {};
+        teleinfo.loop();
+        const size_t parsed = pending - rx.size();
+        maxWork = { std::max(maxWork.scanned, work.scanned), std::max(maxWork.lines, work.lines),
+                    std::max(maxWork.compares, work.compares), std::max(maxWork.moved, work.moved) };
+        idle = parsed == 0 ? idle + 1 : 0;
+        if (idle > 1 || parsed > TELEINFO_LOOP_MAXBYTES || work.scanned > workBound.scanned || work.lines > workBound.lines
+            || work.compares > workBound.compares || work.moved > workBound.moved) {
+            fprintf(stderr, "Loop parsed %zu bytes of %zu: %zu scanned, %zu line bytes, %zu label compares, %zu moved\n",
+                    parsed, pending, work.scanned, work.lines, work.compares, work.moved);
+            abort();
+        }
+        now += 1000;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzzLine(data, size);
+    return 0;
+}
+
+#ifndef TELEINFO_LIBFUZZER
+static void fuzzLine(const std::string& bytes) { fuzzLine((const uint8_t*)bytes.data(), bytes.size()); }
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            std::ifstream file(argv[i], std::ios::binary);
+            CHECK(file);
+            fuzzLine(std::string(std::istreambuf_iterator<char>(file), {}));
+        }
+        return 0;
+    }
+
+    // No end of line: buffer full of dummies
+    fuzzLine(std::string(4 * TELEINFO_BUFFERSIZE, 'A'));
+    fuzzLine(std::string(TELEINFO_BUFFERSIZE - 1, '9') + "\r" + std::string(TELEINFO_BUFFERSIZE + 1, ' ') + "\r");
+    // Only ends of line, only spaces, empty lines
+    fuzzLine(std::string(2048, '\r'));
+    fuzzLine(std::string(2048, ' '));
+    std::string lines;
+    for (int i = 0; i < 256; ++i) lines += i % 2 ? "\n \r" : "\n  \r";
+    fuzzLine(lines);
+    // Every label with the longest data, with too long data, without data
+    std::string frame = "\x02";
+    for (unsigned int i = 0; i < TeleInfoCount; ++i) {
+        const std::string label(TeleInfoParam[i].key, TeleInfoParam[i].keySize - 1);
+        frame += ticLine(label, std::string(TeleInfoParam[i].size, '9')) + ticLine(label, std::string(64, '9')) + ticLine(label, "");
+    }
+    fuzzLine(frame + "\x03");
+
+    // Random bytes and mutations of a valid frame
+    std::mt19937 rng(2026);
+    const std::string valid = ticFrame({ { "ADCO", "012345678901" }, { "OPTARIF", "HC.." }, { "ISOUSC", "45" }, { "HCHC", index(1234567) },
+                                         { "HCHP", index(7654321) }, { "PTEC", "HP.." }, { "IINST", "002" }, { "PAPP", "00450" } });
+    for (int i = 0; i < 200; ++i) {
+        std::string bytes(std::uniform_int_distribution<size_t>(0, 4096)(rng), '\0');
+        for (char& c : bytes) c = (char)rng();
+        fuzzLine(bytes);
+        bytes = valid + valid;
+        for (int flip = 0; flip < 8; ++flip) bytes[std::uniform_int_distribution<size_t>(0, bytes.size() - 1)(rng)] = (char)rng();
+        fuzzLine(bytes);
+    }
+    printf("Max TeleInfo loop work: %zu scanned, %zu line bytes, %zu label compares, %zu moved\n",
+           maxWork.scanned, maxWork.lines, maxWork.compares, maxWork.moved);
+    return 0;
+}
+#endif
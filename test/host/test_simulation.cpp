@@ -0,0 +1,174 @@
+/*
+ * TeleInfo KNX - Host test
+ *  Multi-year simulation: synthetic HC/HP consumption, KNX clock answering the time requests, random resets without
+ *  power loss (warm start, sometimes with a corrupted snapshot), brownouts and power cuts (cold start from flash)
+ *  Checks the history group objects against the simulated meter, and the flash writes per year
+ *  Usage: test_simulation [years] [seed]
+ */
+#include "history_export.h"
+
+#include <map>
+#include <random>
+
+using namespace host;
+
+#define SIMULATION_STEP             ( 15 * 60 )     // A TeleInfo frame every 15 minutes (s)
+#define SIMULATION_RESET_RATE       ( 1. / 96 / 2 ) // Per step: every 2 days (watchdog, software reset)
+#define SIMULATION_BROWNOUT_RATE    ( 1. / 96 / 7 ) // Per step: every week
+#define SIMULATION_POWERCUT_RATE    ( 1. / 96 / 15 )// Per step: every 15 days
+#define SIMULATION_DAY_WINDOW       30              // Time around a day change without consumption (s)
+#define SIMULATION_MARGIN           60              // Cold start closer than that to a boundary (s): the boundary is not observed
+#define FLASH_WRITES_PER_YEAR_MAX   12              // A history save per month
+
+static const time_t start = 1767182400;    // 2025-12-31 12:00:00 UTC
+static uint64_t wall = 0;                   // Simulated wall time since start (us)
+static uint64_t bootWall = 0;               // Wall time of the last reset
+static std::mt19937 rng;
+
+struct Indexes { uint32_t hc = 10000000, hp = 20000000; uint32_t tariff(int i) const { return i == 0 ? hc + hp : i == 1 ? hc : hp; } };
+static Indexes meter;
+static std::map<int64_t, Indexes> midnight;             // Meter indexes at each day boundary (days since epoch)
+static std::vector<std::pair<uint64_t, uint64_t>> coldPeriods;  // Device down or cold started (wall time, us)
+
+static struct tm civil(uint64_t wallUs) { const time_t t = start + wallUs / 1000000; struct tm date; gmtime_r(&t, &date); return date; }
+static int64_t dayOf(uint64_t wallUs) { return (start + wallUs / 1000000) / 86400; }
+static uint64_t boundaryOf(int64_t day) { return (uint64_t)(day * 86400 - start) * 1000000; }
+
+static void advance(uint64_t us) { now += us; wall += us; }
+// Main loop calls, the KNX clock answers the time requests at once
+static void loops(int count, uint64_t stepUs) {
+    for (int i = 0; i < count; ++i, advance(stepUs)) {
+        loop();
+        if (!readRequests.empty()) {
+            const struct tm date = civil(wall);
+            setDateTime(date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, date.tm_hour, date.tm_min, date.tm_sec);
+            readRequests.clear();
+        }
+    }
+}
+static void feedMeter(const struct tm& date) {
+    const bool offPeak = date.tm_hour >= 22 || date.tm_hour < 6;
+    feed(ticFrame({ { "ADCO", "012345678901" }, { "OPTARIF", "HC.." }, { "ISOUSC", "45" }, { "HCHC", index(meter.hc) }, { "HCHP", index(meter.hp) },
+                    { "PTEC", offPeak ? "HC.." : "HP.." }, { "IINST", "002" }, { "PAPP", "00450" } }));
+}
+
+// Device running without cold start from the boundary of day 'from' to the boundary of day 'to'
+static bool warm(int64_t from, int64_t to) {
+    const uint64_t begin = boundaryOf(from) - SIMULATION_MARGIN * 1000000ULL, end = boundaryOf(to) + SIMULATION_MARGIN * 1000000ULL;
+    for (const auto& cold : coldPeriods) {
+        if (cold.first < end && cold.second > begin) return false;
+    }
+    return true;
+}
+static int64_t monthStart(int64_t day) { return day - (civil(boundaryOf(day)).tm_mday - 1); }
+static int64_t yearStart(int64_t day) { return day - civil(boundaryOf(day)).tm_yday; }
+
+static int checks[3] = {0}, exact[3] = {0};    // Yesterday, last month, last year
+// History group objects emitted since the last reset or check
+static bool checkHistory() {
+    for (const Telegram& telegram : sent) {
+        const uint64_t when = bootWall + telegram.time + SIMULATION_DAY_WINDOW * 1000000ULL;  // Day changes seen early by the device
+        // Boundaries of the period reported by yesterday, last month and last year group objects
+        const int64_t day = dayOf(when), month = monthStart(day), year = yearStart(day);
+        const int64_t ends[] = { day, month, year }, references[] = { day - 1, monthStart(month - 1), yearStart(year - 1) };
+        for (int kind = 0; kind < 3; ++kind) {
+            const int64_t end = ends[kind], reference = references[kind];
+            for (int t = 0; t < 3; ++t) {
+                if (telegram.go != historyGO(t, 2 * kind + 1) || !midnight.count(end) || !midnight.count(reference)) continue;
+                uint32_t value = 0;
+                for (uint8_t b : telegram.payload) value = (value << 8) | b;
+                const uint32_t truth = midnight[end].tariff(t) - midnight[reference].tariff(t);
+                ++checks[kind];
+                if (value > truth) {
+                    fprintf(stderr, "Day %lld: history GO %u is %u, more than the %u consumed\n", (long long)end, telegram.go, value, truth);
+                    return false;
+                }
+                // Day values need the whole day without cold start, month and year values are kept in flash
+                if (kind == 0 ? warm(reference, end) : warm(reference, reference) && warm(end, end)) {
+                    if (value != truth) {
+                        fprintf(stderr, "Day %lld: history GO %u is %u instead of %u\n", (long long)end, telegram.go, value, truth);
+                        return false;
+                    }
+                    ++exact[kind];
+                }
+            }
+        }
+    }
+    sent.clear();
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    const int years = argc > 1 ? atoi(argv[1]) : 3;
+    rng.seed(argc > 2 ? atoi(argv[2]) : 2026);
+    std::uniform_int_distribution<int> consumption(0, 400);    // Wh per step (0 to 1.6kW)
+    std::uniform_real_distribution<double> event(0, 1);
+
+    configure(60, 0, 15, false);
+    boot();
+    uint32_t flashErasesBoot = flashErases;     // Flash writes at the last cold start
+    std::map<int, uint32_t> flashPerYear;
+
+    const uint64_t end = (uint64_t)(years * 365.25 * 86400 + 43200) * 1000000;
+    const uint64_t period = SIMULATION_STEP * 1000000ULL;   // Steps are aligned on the start (12:00)
+    while (wall < end) {
+        const uint32_t flashErasesBefore = flashErases;
+        // Frame of the indexes at the step time, received before it: the device clock can be a few seconds off
+        // (synchronized every hour to the second), day changes are awaited during SIMULATION_DAY_WINDOW
+        const uint64_t stepTime = (wall / period + (wall % period > period - 60000000 ? 2 : 1)) * period;
+        const bool dayChange = (start + stepTime / 1000000) % 86400 == 0;
+        const uint64_t window = dayChange ? SIMULATION_DAY_WINDOW * 1000000ULL : 1000000;
+        advance(stepTime - window - wall);
+        const struct tm date = civil(stepTime);
+        feedMeter(date);
+        if (dayChange) midnight[dayOf(stepTime)] = meter;
+        loops(10, 1000);            // Frame parsing
+        loops(2 * window / 100000, 100000);
+        (date.tm_hour >= 22 || date.tm_hour < 6 ? meter.hc : meter.hp) += consumption(rng);
+
+        // Resets away from the steps (a reset within a second of a day change may shift the last second of consumption)
+        const double e = event(rng);
+        if (e < SIMULATION_POWERCUT_RATE + SIMULATION_BROWNOUT_RATE + SIMULATION_RESET_RATE) {
+            advance(7 * 60 * 1000000ULL);
+            loops(1, 1000);     // Running until the reset (warm start snapshot of the last second)
+            if (!checkHistory()) return 1;
+            const bool powerCut = e < SIMULATION_POWERCUT_RATE, brownout = !powerCut && e < SIMULATION_POWERCUT_RATE + SIMULATION_BROWNOUT_RATE;
+            const uint64_t down = powerCut ? std::uniform_int_distribution<uint64_t>(60, 6 * 3600)(rng) * 1000000
+                                : brownout ? std::uniform_int_distribution<uint64_t>(1000, 500000)(rng) : std::uniform_int_distribution<uint64_t>(1000, 50000)(rng);
+            bool cold = powerLoss = powerCut || brownout;    // RAM may survive a brownout, not the time base
+            if (powerCut) {
+                for (size_t i = 0; i < sizeof(warmStart); ++i) ((uint8_t*)&warmStart)[i] = (uint8_t)rng();
+            }
+            else if (!brownout && event(rng) < 0.1) {
+                ((uint8_t*)&warmStart)[std::uniform_int_distribution<size_t>(0, sizeof(warmStart) - 1)(rng)] ^= 0x10;
+                cold = true;
+            }
+            if (cold) coldPeriods.push_back({ wall, wall + down });
+            wall += down;
+            bootWall = wall;
+            boot();
+            if (cold) flashErasesBoot = flashErases;
+            feedMeter(civil(wall));  // The meter keeps sending
+            loops(10, 1000);
+            loops(25, 100000);
+        }
+        flashPerYear[civil(wall).tm_year + 1900] += flashErases - flashErasesBefore;
+
+        if (!checkHistory()) return 1;
+    }
+
+    printf("Simulated %d years: %zu cold starts, %d/%d yesterday, %d/%d last month, %d/%d last year values exact\n",
+           years, coldPeriods.size(), exact[0], checks[0], exact[1], checks[1], exact[2], checks[2]);
+    for (const auto& year : flashPerYear) {
+        printf("%d: %u history flash writes\n", year.first, year.second);
+        CHECK(year.second <= FLASH_WRITES_PER_YEAR_MAX);
+    }
+    CHECK(exact[0] > years * 300 && exact[1] > years * 8 && exact[2] >= years - 1);
+
+    // Flash writes since the last cold start in the export
+    std::vector<uint8_t> raw;
+    HistoryExport history;
+    CHECK(readHistoryExport(raw) && decodeHistoryExport(raw, history));
+    CHECK(history.version >= 2 && history.flashWrites == flashErases - flashErasesBoot);
+    return 0;
+}